@@ -9,6 +9,8 @@
 /// ReadFrom/WriteBack to fetch the contents of the directory from disk, and
 /// to write back any modifications back to disk.
 ///
+/// Names are found through a hash table built when the directory is read.
+///
 /// Also, this implementation has the restriction that the size of the
 /// directory cannot expand.  In other words, once all the entries in the
 /// directory are used, no more files can be created.  Fixing this is one of
@@ -23,6 +25,7 @@
 #include "directory.hh"
 #include "directory_entry.hh"
 #include "file_header.hh"
+#include "lib/slab.hh"
 #include "lib/utility.hh"
 
 #include <stdio.h>
@@ -35,9 +38,10 @@
 ///
 /// * `size` is the number of entries in the directory.
 Directory::Directory(unsigned size)
+    : names(size)
 {
     ASSERT(size > 0);
-    raw.table = new DirectoryEntry [size];
+    raw.table = (DirectoryEntry *) SlabAlloc(size * sizeof (DirectoryEntry));
     raw.tableSize = size;
     for (unsigned i = 0; i < raw.tableSize; i++) {
         raw.table[i].inUse = false;
@@ -47,7 +51,28 @@ Directory::Directory(unsigned size)
 /// De-allocate directory data structure.
 Directory::~Directory()
 {
-    delete [] raw.table;
+    SlabFree(raw.table, raw.tableSize * sizeof (DirectoryEntry));
+}
+
+/// Cache for `Directory` objects, built on first use.
+static SlabCache &
+DirectoryCache()
+{
+    static SlabCache cache("Directory", sizeof (Directory));
+    return cache;
+}
+
+void *
+Directory::operator new(size_t size)
+{
+    ASSERT(size == sizeof (Directory));
+    return DirectoryCache().Alloc();
+}
+
+void
+Directory::operator delete(void *p)
+{
+    DirectoryCache().Free(p);
 }
 
 /// Read the contents of the directory from disk.
@@ -59,6 +84,21 @@ Directory::FetchFrom(OpenFile *file)
     ASSERT(file != nullptr);
     file->ReadAt((char *) raw.table,
                  raw.tableSize * sizeof (DirectoryEntry), 0);
+    IndexNames();
+}
+
+/// Names are compared up to `FILE_NAME_MAX_LEN` characters, so they are
+/// cut there, in case the table on disk has longer ones.
+void
+Directory::IndexNames()
+{
+    names.Clear();
+    for (unsigned i = 0; i < raw.tableSize; i++) {
+        if (raw.table[i].inUse) {
+            raw.table[i].name[FILE_NAME_MAX_LEN] = '\0';
+            names.Put(raw.table[i].name, i);
+        }
+    }
 }
 
 /// Write any modifications to the directory back to disk.
@@ -81,13 +121,15 @@ Directory::FindIndex(const char *name)
 {
     ASSERT(name != nullptr);
 
-    for (unsigned i = 0; i < raw.tableSize; i++) {
-        if (raw.table[i].inUse
-              && !strncmp(raw.table[i].name, name, FILE_NAME_MAX_LEN)) {
-            return i;
-        }
+    // Only the first `FILE_NAME_MAX_LEN` characters count.
+    char key[FILE_NAME_MAX_LEN + 1];
+    strncpy(key, name, FILE_NAME_MAX_LEN);
+    key[FILE_NAME_MAX_LEN] = '\0';
+
+    if (!names.HasKey(key)) {
+        return -1;  // name not in directory
     }
-    return -1;  // name not in directory
+    return names.Get(key);
 }
 
 /// Look up file name in directory, and return the disk sector number where
@@ -126,7 +168,9 @@ Directory::Add(const char *name, int newSector)
         if (!raw.table[i].inUse) {
             raw.table[i].inUse = true;
             strncpy(raw.table[i].name, name, FILE_NAME_MAX_LEN);
+            raw.table[i].name[FILE_NAME_MAX_LEN] = '\0';
             raw.table[i].sector = newSector;
+            names.Put(raw.table[i].name, i);
             return true;
         }
     }
@@ -146,6 +190,7 @@ Directory::Remove(const char *name)
     if (i == -1) {
         return false;  // name not in directory
     }
+    names.Remove(raw.table[i].name);
     raw.table[i].inUse = false;
     return true;
 }
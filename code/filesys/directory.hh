@@ -17,6 +17,7 @@
 
 #include "raw_directory.hh"
 #include "open_file.hh"
+#include "lib/hash_map.hh"
 
 
 /// The following class defines a UNIX-like “directory”.  Each entry in the
@@ -37,6 +38,10 @@ public:
     /// De-allocate the directory.
     ~Directory();
 
+    /// Directories, and their tables, come from slab caches.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     /// Initialize directory contents from disk.
     void FetchFrom(OpenFile *file);
 
@@ -70,6 +75,13 @@ private:
     int FindIndex(const char *name);
 
     RawDirectory raw;
+
+    /// Index into the table of the entry in use of each name.  Keys point
+    /// to the names in the table.
+    HashMap<const char *, unsigned> names;
+
+    /// Rebuild `names` from the table.
+    void IndexNames();
 };
 
 
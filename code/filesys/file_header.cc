@@ -25,11 +25,33 @@
 
 #include "file_header.hh"
 #include "threads/system.hh"
+#include "lib/slab.hh"
 
 #include <ctype.h>
 #include <stdio.h>
 
 
+/// Cache for `FileHeader` objects, built on first use.
+static SlabCache &
+FileHeaderCache()
+{
+    static SlabCache cache("FileHeader", sizeof (FileHeader));
+    return cache;
+}
+
+void *
+FileHeader::operator new(size_t size)
+{
+    ASSERT(size == sizeof (FileHeader));
+    return FileHeaderCache().Alloc();
+}
+
+void
+FileHeader::operator delete(void *p)
+{
+    FileHeaderCache().Free(p);
+}
+
 /// Initialize a fresh file header for a newly created file.  Allocate data
 /// blocks for the file out of the map of free disk blocks.  Return false if
 /// there are not enough free blocks to accomodate the new file.
@@ -49,8 +71,11 @@ FileHeader::Allocate(Bitmap *freeMap, unsigned fileSize)
 
     if (fileSize <= MAX_FILE_SIZE) {
         DEBUG('f', "Creando file header simple\n");
+        // Keep the data in one run of sectors when there is one.
+        int run = raw.numSectors > 0
+                  ? freeMap->FindContiguous(raw.numSectors) : -1;
         for (unsigned i = 0; i < raw.numSectors; i++)
-            raw.dataSectors[i] = freeMap->Find();
+            raw.dataSectors[i] = run != -1 ? run + i : freeMap->Find();
     }
     else {
         unsigned numIndirect = DivRoundUp(raw.numSectors, NUM_DIRECT);
@@ -260,7 +285,7 @@ FileHeader::FileLength() const
 void
 FileHeader::Print(const char *title)
 {
-    char *data = new char [SECTOR_SIZE];
+    char *data = (char *) SlabAlloc(SECTOR_SIZE);
 
     if (title == nullptr) {
         printf("File header:\n");
@@ -289,7 +314,7 @@ FileHeader::Print(const char *title)
         }
         printf("\n");
     }
-    delete [] data;
+    SlabFree(data, SECTOR_SIZE);
 }
 
 const RawFileHeader *
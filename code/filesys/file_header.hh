@@ -34,6 +34,10 @@
 class FileHeader {
 public:
 
+    /// File headers come from a slab cache.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     /// Initialize a file header, including allocating space on disk for the
     /// file data.
     bool Allocate(Bitmap *bitMap, unsigned fileSize);
@@ -16,14 +16,15 @@
 /// that the file system can find them on bootup.
 ///
 /// The file system assumes that the bitmap and directory files are kept
-/// “open” continuously while Nachos is running.
+/// “open” continuously while Nachos is running.  The directory is also kept
+/// in memory, so that looking a name up does not read it from disk.
 ///
 /// For those operations (such as `Create`, `Remove`) that modify the
 /// directory and/or bitmap, if the operation succeeds, the changes are
 /// written immediately back to disk (the two files are kept open during all
 /// this time).  If the operation fails, and we have modified part of the
-/// directory and/or bitmap, we simply discard the changed version, without
-/// writing it back to disk.
+/// bitmap, we simply discard the changed version, without writing it back to
+/// disk; a change to the directory is undone.
 ///
 /// Our implementation at this point has the following restrictions:
 ///
@@ -69,11 +70,8 @@ static const unsigned DIRECTORY_SECTOR = 1;
 FileSystem::FileSystem(bool format)
 {
     DEBUG('f', "Initializing the file system.\n");
-    fileDatas = (fileDataEntry *) malloc(sizeof(fileDataEntry)*(NUM_DIR_ENTRIES+2));
-
-    for(unsigned i = 0; i < NUM_DIR_ENTRIES+2; i++){
-            fileDatas[i].sector = -1;
-    }
+    fileDatas = new HashMap<int, fileDataEntry *>(NUM_DIR_ENTRIES + 2);
+    fileDataLock = new Lock("FileData Lock");
 
     if (format) {
         Bitmap     *freeMap = new Bitmap(NUM_SECTORS);
@@ -121,13 +119,13 @@ FileSystem::FileSystem(bool format)
         DEBUG('f', "Writing bitmap and directory back to disk.\n");
         freeMap->WriteBack(freeMapFile);     // flush changes to disk
         dir->WriteBack(directoryFile);
+        directory = dir;
 
         if (debug.IsEnabled('f')) {
             freeMap->Print();
             dir->Print();
 
             delete freeMap;
-            delete dir;
             delete mapH;
             delete dirH;
         }
@@ -139,13 +137,16 @@ FileSystem::FileSystem(bool format)
         freeMapFile->fileData = GetData(FREE_MAP_SECTOR);
         directoryFile = new OpenFile(DIRECTORY_SECTOR);
         directoryFile->fileData = GetData(DIRECTORY_SECTOR);
+        directory = new Directory(NUM_DIR_ENTRIES);
+        directory->FetchFrom(directoryFile);
     }
 
-    fileSysLock = new Lock("FileSys Lock");
+    fileSysLock = new RWLock("FileSys Lock");
 }
 
 FileSystem::~FileSystem()
 {
+    delete directory;
     delete freeMapFile;
     delete directoryFile;
 }
@@ -183,12 +184,10 @@ FileSystem::Create(const char *name, unsigned initialSize)
 
     DEBUG('f', "Creating file %s, size %u\n", name, initialSize);
 
-    Directory *dir = new Directory(NUM_DIR_ENTRIES);
-    fileSysLock->Acquire();
-    dir->FetchFrom(directoryFile);
+    fileSysLock->AcquireWrite();
     bool success;
 
-    if (dir->Find(name) != -1) {
+    if (directory->Find(name) != -1) {
         success = false;  // File is already in directory.
     } else {
         Bitmap *freeMap = new Bitmap(NUM_SECTORS);
@@ -197,7 +196,7 @@ FileSystem::Create(const char *name, unsigned initialSize)
           // Find a sector to hold the file header.
         if (sector == -1) {
             success = false;  // No free block for file header.
-        } else if (!dir->Add(name, sector)) {
+        } else if (!directory->Add(name, sector)) {
             success = false;  // No space in directory.
         } else {
             FileHeader *h = new FileHeader;
@@ -206,16 +205,17 @@ FileSystem::Create(const char *name, unsigned initialSize)
             if (success) {
                 // Everything worked, flush all changes back to disk.
                 h->WriteBack(sector);
-                dir->WriteBack(directoryFile);
+                directory->WriteBack(directoryFile);
                 freeMap->WriteBack(freeMapFile);
+            } else {
+                directory->Remove(name);
             }
             delete h;
         }
         delete freeMap;
     }
 
-    fileSysLock->Release();
-    delete dir;
+    fileSysLock->ReleaseWrite();
     return success;
 }
 
@@ -231,19 +231,16 @@ FileSystem::Open(const char *name)
 {
     ASSERT(name != nullptr);
 
-    Directory *dir = new Directory(NUM_DIR_ENTRIES);
-    OpenFile  *openFile = nullptr;
+    OpenFile *openFile = nullptr;
 
     DEBUG('f', "Opening file %s\n", name);
-    fileSysLock->Acquire();
-    dir->FetchFrom(directoryFile);
-    int sector = dir->Find(name);
+    fileSysLock->AcquireRead();
+    int sector = directory->Find(name);
     if (sector >= 0) {
         openFile = new OpenFile(sector);  // `name` was found in directory.
         openFile->fileData = GetData(sector);
     }
-    fileSysLock->Release();
-    delete dir;
+    fileSysLock->ReleaseRead();
     return openFile;  // Return null if not found.
 }
 
@@ -264,12 +261,10 @@ FileSystem::Remove(const char *name)
 {
     ASSERT(name != nullptr);
 
-    Directory *dir = new Directory(NUM_DIR_ENTRIES);
-    fileSysLock->Acquire();
-    dir->FetchFrom(directoryFile);
-    int sector = dir->Find(name);
+    fileSysLock->AcquireWrite();
+    int sector = directory->Find(name);
     if (sector == -1) {
-       delete dir;
+       fileSysLock->ReleaseWrite();
        return false;  // file not found
     }
 
@@ -283,16 +278,15 @@ FileSystem::Remove(const char *name)
 
         fileH->Deallocate(freeMap);  // Remove data blocks.
         freeMap->Clear(sector);      // Remove header block.
-        dir->Remove(name);
+        directory->Remove(name);
 
-        freeMap->WriteBack(freeMapFile);  // Flush to disk.
-        dir->WriteBack(directoryFile);    // Flush to disk.
+        freeMap->WriteBack(freeMapFile);      // Flush to disk.
+        directory->WriteBack(directoryFile);  // Flush to disk.
         delete fileH;
-        delete dir;
         delete freeMap;
     }
 
-    fileSysLock->Release();
+    fileSysLock->ReleaseWrite();
     return true;
 }
 
@@ -302,7 +296,7 @@ FileSystem::Extend(FileHeader *fileH, unsigned newFilesize)
 {
     ASSERT(fileH != nullptr);
 
-    fileSysLock->Acquire();
+    fileSysLock->AcquireWrite();
 
     Bitmap *freeMap = new Bitmap(NUM_SECTORS);
     freeMap->FetchFrom(freeMapFile);
@@ -313,7 +307,7 @@ FileSystem::Extend(FileHeader *fileH, unsigned newFilesize)
 
     delete freeMap;
 
-    fileSysLock->Release();
+    fileSysLock->ReleaseWrite();
     return true;
 }
 
@@ -322,55 +316,44 @@ FileSystem::Extend(FileHeader *fileH, unsigned newFilesize)
 void
 FileSystem::List()
 {
-    Directory *dir = new Directory(NUM_DIR_ENTRIES);
-
-    fileSysLock->Acquire();
-    dir->FetchFrom(directoryFile);
-    dir->List();
-    fileSysLock->Release();
-    delete dir;
+    fileSysLock->AcquireRead();
+    directory->List();
+    fileSysLock->ReleaseRead();
 }
 
 // Busca el file data correspondiente al sector, si no existe lo crea
 fileDataEntry *
 FileSystem::GetData(int sector){
-    for(unsigned i = 0; i < NUM_DIR_ENTRIES+2; i++){
-        if(fileDatas[i].sector == sector)
-            return &fileDatas[i];
-    }
-
-    for(unsigned i = 0; i < NUM_DIR_ENTRIES+2; i++){
-        if(fileDatas[i].sector == -1){
-            fileDatas[i].sector = sector;
-            fileDatas[i].fileLock = new Lock("SomeFileLock");
-            fileDatas[i].numOpens = 1;
-            fileDatas[i].deleteRequested = false;
-            return &fileDatas[i];
-        }     
+    // Several threads may be opening files at once.
+    fileDataLock->Acquire();
+    fileDataEntry *entry = fileDatas->Get(sector);
+    if (entry == nullptr) {
+        entry = new fileDataEntry;
+        entry->sector = sector;
+        entry->fileLock = new RWLock("SomeFileLock");
+        entry->numOpens = 1;
+        entry->deleteRequested = false;
+        fileDatas->Put(sector, entry);
     }
-    return nullptr;
+    fileDataLock->Release();
+    return entry;
 }
 
 // Borra el file data correspondiente al sector si numOpens es igual a 1 y devuelve true, si no devuelve false
 bool
 FileSystem::DeleteData(int sector){
-    for(unsigned i = 0; i < NUM_DIR_ENTRIES+2; i++){
-        if(fileDatas[i].sector == sector){
-            if(fileDatas[i].numOpens == 1 ){
-                fileDatas[i].sector = -1;
-                delete fileDatas[i].fileLock;
-                fileDatas[i].numOpens = 0;
-                fileDatas[i].deleteRequested = false;
-                return true;
-            }
-            else{
-                fileDatas[i].numOpens--;
-                return false;
-            }
-        }     
+    fileDataEntry *entry = fileDatas->Get(sector);
+    if (entry == nullptr) {
+        return true; // Caso que nunca fue abierto (archivo guardado de antes)
     }
-
-    return true; // Caso que nunca fue abierto (archivo guardado de antes)
+    if (entry->numOpens == 1) {
+        fileDatas->Remove(sector);
+        delete entry->fileLock;
+        delete entry;
+        return true;
+    }
+    entry->numOpens--;
+    return false;
 }
 
 
@@ -558,7 +541,7 @@ FileSystem::Check()
 void
 FileSystem::Print()
 {
-    fileSysLock->Acquire();
+    fileSysLock->AcquireRead();
 
     FileHeader *bitH    = new FileHeader;
     FileHeader *dirH    = new FileHeader;
@@ -582,7 +565,7 @@ FileSystem::Print()
     dir->Print();
     printf("--------------------------------\n");
 
-    fileSysLock->Release();
+    fileSysLock->ReleaseRead();
 
     delete bitH;
     delete dirH;
@@ -37,11 +37,14 @@
 
 
 #include "open_file.hh"
+#include "lib/hash_map.hh"
 #include "threads/lock.hh"
+#include "threads/rw_lock.hh"
 
 struct fileDataEntry {
     int sector;
-    Lock *fileLock; 
+    RWLock *fileLock;  ///< Shared by readers of the file, exclusive for
+                       ///< writers.
     unsigned numOpens;
     bool deleteRequested;
 };
@@ -104,6 +107,9 @@ public:
 #include "machine/disk.hh"
 
 
+class Directory;
+
+
 /// Initial file sizes for the bitmap and directory; until the file system
 /// supports extensible files, the directory size sets the maximum number of
 /// files that can be loaded onto the disk.
@@ -152,8 +158,17 @@ private:
     OpenFile *directoryFile;  ///< “Root” directory -- list of file names,
                               ///< represented as a file.
 
-    fileDataEntry *fileDatas;
-    Lock *fileSysLock;
+    /// The root directory, read once and then kept in memory along with its
+    /// index of names.  Changes are written through to `directoryFile`.
+    Directory *directory;
+
+    /// Shared data of each open file, by header sector.
+    HashMap<int, fileDataEntry *> *fileDatas;
+    Lock *fileDataLock;  ///< Protects `fileDatas`.
+
+    /// Held for reading while looking the directory up, and for writing
+    /// while changing the directory or the bitmap.
+    RWLock *fileSysLock;
 };
 
 #endif
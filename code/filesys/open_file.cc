@@ -14,7 +14,8 @@
 #include "open_file.hh"
 #include "file_header.hh"
 #include "threads/system.hh"
-#include "threads/lock.hh"
+#include "threads/rw_lock.hh"
+#include "lib/slab.hh"
 
 
 #include <string.h>
@@ -113,7 +114,7 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
     ASSERT(numBytes > 0);
 
     unsigned fileLength = hdr->FileLength();
-    Lock *fileLock = fileData->fileLock;
+    RWLock *fileLock = fileData->fileLock;
     unsigned firstSector, lastSector, numSectors;
     char *buf;
 
@@ -131,17 +132,18 @@ OpenFile::ReadAt(char *into, unsigned numBytes, unsigned position)
     numSectors = 1 + lastSector - firstSector;
 
     // Read in all the full and partial sectors that we need.
-    buf = new char [numSectors * SECTOR_SIZE];    
-    if(!writing) fileLock->Acquire();
+    buf = (char *) SlabAlloc(numSectors * SECTOR_SIZE);
+    // Readers share the lock; `WriteAt` already holds it exclusively.
+    if(!writing) fileLock->AcquireRead();
     for (unsigned i = firstSector; i <= lastSector; i++) {
         synchDisk->ReadSector(hdr->ByteToSector(i * SECTOR_SIZE),
                               &buf[(i - firstSector) * SECTOR_SIZE]);
     }
-    if(!writing) fileLock->Release();
+    if(!writing) fileLock->ReleaseRead();
 
     // Copy the part we want.
     memcpy(into, &buf[position - firstSector * SECTOR_SIZE], numBytes);
-    delete [] buf;
+    SlabFree(buf, numSectors * SECTOR_SIZE);
     return numBytes;
 }
 
@@ -152,7 +154,7 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
     ASSERT(numBytes > 0);
 
     unsigned fileLength = hdr->FileLength();
-    Lock *fileLock = fileData->fileLock;
+    RWLock *fileLock = fileData->fileLock;
     unsigned firstSector, lastSector, numSectors;
     bool firstAligned, lastAligned;
     char *buf;
@@ -160,7 +162,7 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
     DEBUG('f', "Writing %u bytes at %u, from file of length %u.\n",
           numBytes, position, fileLength);
 
-    fileLock->Acquire();
+    fileLock->AcquireWrite();
     writing = true;
     if (position + numBytes > fileLength) {
         unsigned expand = numBytes;
@@ -176,7 +178,7 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
     lastSector  = DivRoundDown(position + numBytes - 1, SECTOR_SIZE);
     numSectors  = 1 + lastSector - firstSector;
 
-    buf = new char [numSectors * SECTOR_SIZE];
+    buf = (char *) SlabAlloc(numSectors * SECTOR_SIZE);
 
     firstAligned = position == firstSector * SECTOR_SIZE;
     lastAligned  = position + numBytes == (lastSector + 1) * SECTOR_SIZE;
@@ -199,8 +201,8 @@ OpenFile::WriteAt(const char *from, unsigned numBytes, unsigned position)
                                &buf[(i - firstSector) * SECTOR_SIZE]);
     }
     writing = false;
-    fileLock->Release();
-    delete [] buf;
+    fileLock->ReleaseWrite();
+    SlabFree(buf, numSectors * SECTOR_SIZE);
     return numBytes;
 }
 
@@ -5,6 +5,7 @@
 
 
 #include "assert.hh"
+#include "utility.hh"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -20,6 +21,13 @@ Assert(bool result, const char *expString, const char *filename,
                         "\tLocation: file `%s`, line %u\n",
                 expString, filename, line);
         fflush(stderr);
+
+        // Show what led here, unless it is the log that failed.
+        static bool printingRing = false;
+        if (!printingRing) {
+            printingRing = true;
+            debug.PrintRing();
+        }
         abort();
     }
 }
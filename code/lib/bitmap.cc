@@ -8,6 +8,8 @@
 
 
 #include "bitmap.hh"
+#include "slab.hh"
+
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -21,21 +23,39 @@ Bitmap::Bitmap(unsigned nitems)
 
     numBits  = nitems;
     numWords = DivRoundUp(numBits, BITS_IN_WORD);
-    map      = new unsigned [numWords];
-    for (unsigned i = 0; i < numBits; i++) {
-        Clear(i);
+    map      = (unsigned *) SlabAlloc(numWords * sizeof (unsigned));
+    for (unsigned i = 0; i < numWords; i++) {
+        map[i] = 0;
     }
-
-    #ifdef SWAP
-    //struct coreEntry coreMap[nitems];
-    coreMap = (coreEntry*) malloc(sizeof(coreEntry)*nitems);
-    #endif
+    numClear = numBits;
+    hint     = 0;
 }
 
 /// De-allocate a bitmap.
 Bitmap::~Bitmap()
 {
-    delete [] map;
+    SlabFree(map, numWords * sizeof (unsigned));
+}
+
+/// Cache for `Bitmap` objects, built on first use.
+static SlabCache &
+BitmapCache()
+{
+    static SlabCache cache("Bitmap", sizeof (Bitmap));
+    return cache;
+}
+
+void *
+Bitmap::operator new(size_t size)
+{
+    ASSERT(size == sizeof (Bitmap));
+    return BitmapCache().Alloc();
+}
+
+void
+Bitmap::operator delete(void *p)
+{
+    BitmapCache().Free(p);
 }
 
 /// Set the “nth” bit in a bitmap.
@@ -45,7 +65,12 @@ void
 Bitmap::Mark(unsigned which)
 {
     ASSERT(which < numBits);
-    map[which / BITS_IN_WORD] |= 1 << which % BITS_IN_WORD;
+
+    unsigned bit = 1u << which % BITS_IN_WORD;
+    if (!(map[which / BITS_IN_WORD] & bit)) {
+        map[which / BITS_IN_WORD] |= bit;
+        numClear--;
+    }
 }
 
 /// Clear the “nth” bit in a bitmap.
@@ -55,7 +80,12 @@ void
 Bitmap::Clear(unsigned which)
 {
     ASSERT(which < numBits);
-    map[which / BITS_IN_WORD] &= ~(1 << which % BITS_IN_WORD);
+
+    unsigned bit = 1u << which % BITS_IN_WORD;
+    if (map[which / BITS_IN_WORD] & bit) {
+        map[which / BITS_IN_WORD] &= ~bit;
+        numClear++;
+    }
 }
 
 /// Return true if the “nth” bit is set.
@@ -65,99 +95,122 @@ bool
 Bitmap::Test(unsigned which) const
 {
     ASSERT(which < numBits);
-    return map[which / BITS_IN_WORD] & 1 << which % BITS_IN_WORD;
+    return map[which / BITS_IN_WORD] & 1u << which % BITS_IN_WORD;
 }
 
-/// Return the number of the first bit which is clear.  As a side effect, set
-/// the bit (mark it as in use).  (In other words, find and allocate a bit.)
-///
-/// If no bits are clear, return -1.
-int
-Bitmap::Find()
+unsigned
+Bitmap::NextClear(unsigned from) const
 {
-    for (unsigned i = 0; i < numBits; i++) {
-        if (!Test(i)) {
-            Mark(i);
-            return i;
+    if (from >= numBits) {
+        return numBits;
+    }
+
+    // Pretend the bits before `from` in its word are set.
+    unsigned w = from / BITS_IN_WORD;
+    unsigned free = ~map[w] & ~0u << from % BITS_IN_WORD;
+    while (free == 0) {
+        if (++w == numWords) {
+            return numBits;
         }
+        free = ~map[w];
     }
-    return -1;
+    unsigned i = w * BITS_IN_WORD + __builtin_ctz(free);
+    return i < numBits ? i : numBits;
 }
 
-/// Return the number of clear bits in the bitmap.  (In other words, how many
-/// bits are unallocated?)
 unsigned
-Bitmap::CountClear() const
+Bitmap::NextSet(unsigned from) const
 {
-    unsigned count = 0;
+    if (from >= numBits) {
+        return numBits;
+    }
 
-    for (unsigned i = 0; i < numBits; i++) {
-        if (!Test(i)) {
-            count++;
+    unsigned w = from / BITS_IN_WORD;
+    unsigned used = map[w] & ~0u << from % BITS_IN_WORD;
+    while (used == 0) {
+        if (++w == numWords) {
+            return numBits;
         }
+        used = map[w];
     }
-    return count;
+    unsigned i = w * BITS_IN_WORD + __builtin_ctz(used);
+    return i < numBits ? i : numBits;
 }
 
-#ifdef SWAP
-unsigned
-Bitmap::GetVPN(int frame)
+/// Return the number of a bit which is clear.  As a side effect, set the bit
+/// (mark it as in use).  (In other words, find and allocate a bit.)
+///
+/// The cached count answers right away when the bitmap is full; otherwise
+/// the search starts at the word of the previous allocation and wraps
+/// around.
+///
+/// If no bits are clear, return -1.
+int
+Bitmap::Find()
 {
-    return coreMap[frame].vpn;
+    if (numClear == 0) {
+        return -1;
+    }
+
+    unsigned i = NextClear(hint * BITS_IN_WORD);
+    if (i == numBits) {
+        i = NextClear(0);
+    }
+    ASSERT(i < numBits);
+    Mark(i);
+    hint = i / BITS_IN_WORD;
+    return i;
 }
 
-Thread*
-Bitmap::GetThread(int frame)
+/// Runs are looked for by jumping from the start of a clear stretch to its
+/// end, and on to the start of the next one, a word at a time.
+int
+Bitmap::FindContiguous(unsigned n)
 {
-    return coreMap[frame].thread;
+    ASSERT(n > 0);
+
+    if (n > numClear) {
+        return -1;
+    }
+    unsigned start = NextClear(0);
+    while (start < numBits && numBits - start >= n) {
+        unsigned end = NextSet(start);
+        if (end - start >= n) {
+            for (unsigned i = start; i < start + n; i++) {
+                Mark(i);
+            }
+            return start;
+        }
+        start = NextClear(end);
+    }
+    return -1;
 }
 
-void
-Bitmap::AddEntry(int frame, unsigned vpn, Thread *current_thread)
+/// Return the number of clear bits in the bitmap.  (In other words, how many
+/// bits are unallocated?)
+unsigned
+Bitmap::CountClear() const
 {
-    coreMap[frame].thread = current_thread;
-    coreMap[frame].vpn = vpn;
+    return numClear;
 }
 
 void
-Bitmap::RemoveEntry(int frame)
+Bitmap::Recount()
 {
-    coreMap[frame].thread = nullptr;
-    coreMap[frame].vpn = (unsigned) -1;
-    Clear(frame);
-}
-
-int
-Bitmap::PickVictim(unsigned num_physical_pages)
-{   
-    static unsigned victim = -1;
-
-    #ifdef PRPOLICY_FIFO
-    victim++;
-    #elif PRPOLICY_CLOCK
-    static unsigned clock = 0;
-    AddressSpace* space  = pages->coreMap[clock].thread->space;
-    unsigned virtualPage = pages->coreMap[clock].virtualPage;
-
-    if (!space->pageTable[virtualPage].use) {
-        victim = clock;
-        clock++;
-        clock %= num_physical_pages;
-    } else {
-        space->pageTable[virtualPage].use = false;
-        clock++;
-        clock %= num_physical_pages;
-        victim = PickVictim();
+    // Bits beyond `numBits` may come from elsewhere; drop them.
+    unsigned extra = numWords * BITS_IN_WORD - numBits;
+    if (extra > 0) {
+        map[numWords - 1] &= ~0u >> extra;
     }
-    #else
-    victim = SystemDep::Random();
-    #endif
 
-    return victim % num_physical_pages;
+    unsigned set = 0;
+    for (unsigned i = 0; i < numWords; i++) {
+        set += __builtin_popcount(map[i]);
+    }
+    numClear = numBits - set;
+    hint     = 0;
 }
 
-#endif
-
 /// Print the contents of the bitmap, for debugging.
 ///
 /// Could be done in a number of ways, but we just print the indexes of all
@@ -184,6 +237,7 @@ Bitmap::FetchFrom(OpenFile *file)
 {
     ASSERT(file != nullptr);
     file->ReadAt((char *) map, numWords * sizeof (unsigned), 0);
+    Recount();
 }
 
 /// Store the contents of a bitmap to a Nachos file.
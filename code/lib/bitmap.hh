@@ -3,7 +3,9 @@
 /// vector.
 ///
 /// The bitmap is represented as an array of unsigned integers, on which we
-/// do modulo arithmetic to find the bit we are interested in.
+/// do modulo arithmetic to find the bit we are interested in.  Searches go
+/// a whole word at a time, skipping full words and picking the first clear
+/// bit of a word by counting trailing zeros.
 ///
 /// The data structure is parameterized with with the number of bits being
 /// managed.
@@ -29,18 +31,6 @@
 ///
 /// Each bit represents whether the corresponding sector or page is in use
 /// or free.
-class Thread;
-
-#ifdef SWAP
-struct coreEntry
-{
-    Thread *thread;
-    unsigned vpn;
-    //bool dirty;
-    //bool used;
-};
-#endif
-
 class Bitmap {
 public:
 
@@ -52,6 +42,10 @@ public:
     /// Uninitialize a bitmap.
     ~Bitmap();
 
+    /// Bitmaps, and their storage, come from slab caches.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     /// Set the “nth” bit.
     void Mark(unsigned which);
 
@@ -63,23 +57,21 @@ public:
 
     /// Return the index of a clear bit, and as a side effect, set the bit.
     ///
+    /// The search starts where the previous one left off (next fit), so
+    /// bits freed behind it are only reused once the end is reached.
+    ///
     /// If no bits are clear, return -1.
     int Find();
 
-    /// Return the number of clear bits.
-    unsigned CountClear() const;
-    
-    #ifdef SWAP
-    unsigned GetVPN(int frame);
-
-    Thread* GetThread(int frame);
-
-    void AddEntry(int frame, unsigned vpn, Thread *current_thread);
-
-    void RemoveEntry(int frame);
+    /// Find `n` consecutive clear bits, set them, and return the index of
+    /// the first one.  The lowest such run is taken.
+    ///
+    /// If there is no such run, return -1.
+    int FindContiguous(unsigned n);
 
-    int PickVictim(unsigned num_physical_pages);
-    #endif
+    /// Return the number of clear bits.  Kept up to date by every change,
+    /// so this takes constant time.
+    unsigned CountClear() const;
 
     /// Print contents of bitmap.
     void Print() const;
@@ -105,12 +97,25 @@ private:
     /// multiple of the number of bits in a word).
     unsigned numWords;
 
-    /// Bit storage.
+    /// Bit storage.  Bits beyond `numBits` in the last word are kept clear.
     unsigned *map;
 
-    #ifdef SWAP
-    coreEntry *coreMap;
-    #endif
+    /// Number of clear bits.
+    unsigned numClear;
+
+    /// Word where the next `Find` starts.
+    unsigned hint;
+
+    /// Index of the first clear bit at or after `from`, or `numBits` if
+    /// there is none.
+    unsigned NextClear(unsigned from) const;
+
+    /// Index of the first set bit at or after `from`, or `numBits` if
+    /// there is none.
+    unsigned NextSet(unsigned from) const;
+
+    /// Count the clear bits again, after the storage changed as a whole.
+    void Recount();
 };
 
 #endif
@@ -18,20 +18,19 @@
 #include <string.h>
 
 
+/// Number of messages kept with the `ring` option.
+static const unsigned RING_SIZE = 1 << 15;
+
 Debug::Debug()
 {
     flags = "";
+    memset(enabled, 0, sizeof enabled);
+    ring = nullptr;
 }
 
-bool
-Debug::IsEnabled(char flag) const
+Debug::~Debug()
 {
-    if (flags != nullptr) {
-        return strchr(flags, flag) != 0
-               || strchr(flags, '+') != 0;
-    } else {
-        return false;
-    }
+    delete ring;
 }
 
 const char *
@@ -44,58 +43,54 @@ void
 Debug::SetFlags(const char *new_flags)
 {
     flags = new_flags;
+
+    bool all = flags != nullptr && strchr(flags, '+') != nullptr;
+    for (unsigned c = 0; c < sizeof enabled; c++) {
+        enabled[c] = all || (flags != nullptr && c != '\0'
+                             && strchr(flags, c) != nullptr);
+    }
 }
 
-void
-Debug::SetOpts(DebugOpts new_opts)
+const DebugOpts &
+Debug::GetOpts() const
 {
-    opts = new_opts;
+    return opts;
 }
 
 void
-Debug::Print(const char *file, const unsigned line, const char *func,
-             char flag, const char *format, ...) const
+Debug::SetOpts(DebugOpts new_opts)
 {
-    ASSERT(format != nullptr);
-
-    if (!IsEnabled(flag)) {
-        return;
-    }
+    opts = new_opts;
 
-    // Option effects preceding the message.
-    if (opts.location) {
-        fprintf(stdout, "[location: %s:%u]\n", file, line);
-    }
-    if (opts.function) {
-        fprintf(stdout, "[function: %s]\n", func);
+    if (opts.ring && ring == nullptr) {
+        ring = new DebugRing(RING_SIZE);
     }
+}
 
-    fprintf(stdout, "[%c] ", flag);
-
-    va_list ap;
-    // You will get an unused variable message here -- ignore it.
-    va_start(ap, format);
-    vfprintf(stdout, format, ap);
-    va_end(ap);
-
-    fflush(stdout);
-
-    // Option effects succeeding the message.
-    if (opts.sleep) {
-        SystemDep::Delay(1);
-    }
-    if (opts.interactive) {
-        getchar();
+void
+Debug::PrintRing() const
+{
+    if (ring != nullptr) {
+        ring->Print(opts);
     }
 }
 
 void
-Debug::PrintCont(char flag, const char *format, ...) const
+Debug::Output(bool cont, const char *file, unsigned line, const char *func,
+              char flag, const char *format, ...) const
 {
     ASSERT(format != nullptr);
 
-    if (!IsEnabled(flag)) {
-        return;
+    // Option effects preceding the message.
+    if (!cont) {
+        if (opts.location) {
+            fprintf(stdout, "[location: %s:%u]\n", file, line);
+        }
+        if (opts.function) {
+            fprintf(stdout, "[function: %s]\n", func);
+        }
+
+        fprintf(stdout, "[%c] ", flag);
     }
 
     va_list ap;
@@ -105,4 +100,14 @@ Debug::PrintCont(char flag, const char *format, ...) const
     va_end(ap);
 
     fflush(stdout);
+
+    // Option effects succeeding the message.
+    if (!cont) {
+        if (opts.sleep) {
+            SystemDep::Delay(1);
+        }
+        if (opts.interactive) {
+            getchar();
+        }
+    }
 }
@@ -15,7 +15,17 @@
 /// * `a` -- address spaces (requires *USER_PROGRAM*).
 /// * `e` -- exception handling (requires *USER_PROGRAM*).
 ///
-/// See also `debug_opts.hh`.
+/// Messages of some flags can be left out of the program altogether, so
+/// that they cost nothing, not even the check of whether they are enabled.
+/// `DEBUG_FLAGS` is the string of flags compiled in; it defaults to `+`,
+/// all of them, and may be set in the `DEFINES` of a `Makefile`, for
+/// instance:
+///
+///     DEFINES += -DDEBUG_FLAGS='"ts"'
+///
+/// Enabling a flag with `-d` has no effect if it is not compiled in.
+///
+/// See also `debug_opts.hh`, and `debug_ring.hh` for the `ring` option.
 ///
 /// Copyright (c) 1992-1993 The Regents of the University of California.
 ///               2016-2021 Docentes de la Universidad Nacional de Rosario.
@@ -28,6 +38,23 @@
 
 
 #include "debug_opts.hh"
+#include "debug_ring.hh"
+
+
+#ifndef DEBUG_FLAGS
+#define DEBUG_FLAGS  "+"
+#endif
+
+/// Are messages of `flag` compiled in?
+///
+/// Meant to be evaluated at compile time, see `DEBUG` in `utility.hh`.
+constexpr bool
+DebugCompiled(char flag, const char *flags = DEBUG_FLAGS)
+{
+    return *flags != '\0'
+           && (*flags == flag || *flags == '+'
+               || DebugCompiled(flag, flags + 1));
+}
 
 
 /// Interface to debugging routines.
@@ -38,6 +65,8 @@ public:
     /// printed until `SetFlags` is called.
     Debug();
 
+    ~Debug();
+
     /// Is this debug flag enabled?
     bool IsEnabled(char flag) const;
 
@@ -56,27 +85,84 @@ public:
     void SetFlags(const char *new_flags);
 
     /// Set debug options.
+    ///
+    /// With the `ring` option, messages are recorded from then on instead
+    /// of printed.
     void SetOpts(DebugOpts new_opts);
 
+    /// Get the current debug options.
+    const DebugOpts &GetOpts() const;
+
     /// Print a debug message if `flag` is enabled.
     ///
     /// Like `printf`, with some extra arguments on the front.
     ///
     /// Put a flag prefix along with the message.
+    template <typename... Args>
     void Print(const char *file, const unsigned line, const char *func,
-               char flag, const char *format, ...) const;
+               char flag, const char *format, Args... args) const;
 
     /// Similar to `Print` but avoid printing the flag prefix.
     ///
     /// Useful for splitting a call for a `Print` line into multiple calls.
-    void PrintCont(char flag, const char *format, ...) const;
+    template <typename... Args>
+    void PrintCont(char flag, const char *format, Args... args) const;
+
+    /// Print the messages recorded with the `ring` option, if any.
+    void PrintRing() const;
 
 private:
     /// String that controls which debug messages are printed.
     const char *flags;
 
+    /// Which flags are enabled, by character, so that checking is quick.
+    bool enabled[256];
+
     DebugOpts opts;
+
+    /// Messages recorded, with the `ring` option; null otherwise.
+    DebugRing *ring;
+
+    /// Print a message right away; `cont` avoids the prefix.
+    void Output(bool cont, const char *file, unsigned line, const char *func,
+                char flag, const char *format, ...) const;
 };
 
 
+inline bool
+Debug::IsEnabled(char flag) const
+{
+    return DebugCompiled(flag) && enabled[(unsigned char) flag];
+}
+
+template <typename... Args>
+void
+Debug::Print(const char *file, const unsigned line, const char *func,
+             char flag, const char *format, Args... args) const
+{
+    if (!IsEnabled(flag)) {
+        return;
+    }
+    if (ring != nullptr) {
+        ring->Record(file, line, func, flag, false, format, args...);
+    } else {
+        Output(false, file, line, func, flag, format, args...);
+    }
+}
+
+template <typename... Args>
+void
+Debug::PrintCont(char flag, const char *format, Args... args) const
+{
+    if (!IsEnabled(flag)) {
+        return;
+    }
+    if (ring != nullptr) {
+        ring->Record(nullptr, 0, nullptr, flag, true, format, args...);
+    } else {
+        Output(true, nullptr, 0, nullptr, flag, format, args...);
+    }
+}
+
+
 #endif
@@ -26,12 +26,38 @@ struct DebugOpts {
     /// Whether to wait for user input right after each debug message.
     bool interactive;
 
+    /// Whether to profile lock contention, and print a report on halt.
+    bool lockProfile;
+
+    /// Whether to validate the order in which locks are acquired, and
+    /// report possible deadlocks.
+    bool lockDep;
+
+    /// Whether to print scheduling statistics on halt.
+    bool schedStats;
+
+    /// Whether to print slab allocator usage on halt.
+    bool slabStats;
+
+    /// Whether to print thread pool usage on halt.
+    bool poolStats;
+
+    /// Whether to record debug messages in memory, and print them on halt,
+    /// instead of printing them right away.
+    bool ring;
+
     DebugOpts()
     {
         location = false;
         function = false;
         sleep = false;
         interactive = false;
+        lockProfile = false;
+        lockDep = false;
+        schedStats = false;
+        slabStats = false;
+        poolStats = false;
+        ring = false;
     }
 };
 
@@ -0,0 +1,203 @@
+/// Routines for the in-memory log of debug messages.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "debug_ring.hh"
+#include "utility.hh"
+
+#include <stdio.h>
+
+
+DebugRing::DebugRing(unsigned size_)
+{
+    ASSERT(size_ > 0);
+
+    size    = size_;
+    entries = new Entry [size];
+    count   = 0;
+}
+
+DebugRing::~DebugRing()
+{
+    delete [] entries;
+}
+
+DebugRing::Entry *
+DebugRing::NewEntry(const char *file, unsigned line, const char *func,
+                    char flag, bool cont, const char *format)
+{
+    Entry *e = &entries[count % size];
+    count++;
+
+    e->file        = file;
+    e->func        = func;
+    e->format      = format;
+    e->line        = line;
+    e->flag        = flag;
+    e->cont        = cont;
+    e->numArgs     = 0;
+    e->stringsUsed = 0;
+    return e;
+}
+
+/// The string is copied into the entry, cut short if there is not enough
+/// room left; the argument keeps where the copy starts.
+void
+DebugRing::Encode(Entry *e, unsigned i, const char *s)
+{
+    if (s == nullptr) {
+        s = "(null)";
+    }
+    unsigned room = STRING_BYTES - e->stringsUsed;
+    if (room == 0) {
+        e->args[i] = STRING_BYTES - 1;  // Points to the last terminator.
+        return;
+    }
+    size_t length = strlen(s);
+    if (length > room - 1) {
+        length = room - 1;
+    }
+    memcpy(&e->strings[e->stringsUsed], s, length);
+    e->strings[e->stringsUsed + length] = '\0';
+    e->args[i] = e->stringsUsed;
+    e->stringsUsed += length + 1;
+}
+
+void
+DebugRing::Encode(Entry *e, unsigned i, char *s)
+{
+    Encode(e, i, (const char *) s);
+}
+
+void
+DebugRing::Encode(Entry *e, unsigned i, double d)
+{
+    memcpy(&e->args[i], &d, sizeof d);
+}
+
+void
+DebugRing::Encode(Entry *e, unsigned i, float f)
+{
+    Encode(e, i, (double) f);
+}
+
+/// Cut `n` to the size given by the length modifier `length` of a
+/// conversion, and extend it again with or without sign.
+static uint64_t
+Resize(uint64_t n, const char *length, bool isSigned)
+{
+    if (strcmp(length, "hh") == 0) {
+        return isSigned ? (uint64_t) (int64_t) (signed char) n
+                        : (unsigned char) n;
+    } else if (strcmp(length, "h") == 0) {
+        return isSigned ? (uint64_t) (int64_t) (short) n
+                        : (unsigned short) n;
+    } else if (length[0] == '\0') {
+        return isSigned ? (uint64_t) (int64_t) (int) n
+                        : (unsigned) n;
+    } else {
+        return n;  // `l`, `ll`, `j`, `z` and `t` are 64 bits wide.
+    }
+}
+
+/// Each conversion of the format is printed on its own, by handing
+/// `printf` the conversion with its flags, width and precision, and with
+/// the argument taken back to the type the conversion expects.  Integers
+/// are always printed as `long long`.
+void
+DebugRing::PrintEntry(const Entry *e)
+{
+    unsigned arg = 0;
+    for (const char *p = e->format; *p != '\0'; p++) {
+        if (*p != '%') {
+            putchar(*p);
+            continue;
+        }
+        if (p[1] == '%') {
+            putchar('%');
+            p++;
+            continue;
+        }
+
+        // Split the conversion into flags, width and precision; length;
+        // and the conversion character.
+        const char *start = p + 1;
+        const char *q = start;
+        while (*q != '\0' && strchr("-+ #0123456789.", *q) != nullptr) {
+            q++;
+        }
+        char spec[32], length[4];
+        unsigned specLength = q - start;
+        unsigned lengthLength = strspn(q, "hlLqjzt");
+        const char *conversion = q + lengthLength;
+        if (*conversion == '\0' || specLength > sizeof spec - 5
+              || lengthLength >= sizeof length) {
+            fputs(p, stdout);  // Malformed, or `*` width; print as is.
+            break;
+        }
+        spec[0] = '%';
+        memcpy(&spec[1], start, specLength);
+        spec[specLength + 1] = '\0';
+        memcpy(length, q, lengthLength);
+        length[lengthLength] = '\0';
+        p = conversion;
+
+        if (arg >= e->numArgs) {
+            fputs("<missing>", stdout);
+            continue;
+        }
+        uint64_t n = e->args[arg++];
+        char c = *conversion;
+        if (strchr("di", c) != nullptr) {
+            strcat(spec, "ll");
+            strncat(spec, &c, 1);
+            printf(spec, (long long) Resize(n, length, true));
+        } else if (strchr("ouxX", c) != nullptr) {
+            strcat(spec, "ll");
+            strncat(spec, &c, 1);
+            printf(spec, (unsigned long long) Resize(n, length, false));
+        } else if (c == 'c') {
+            strncat(spec, &c, 1);
+            printf(spec, (int) n);
+        } else if (c == 's') {
+            strncat(spec, &c, 1);
+            printf(spec, n < STRING_BYTES ? &e->strings[n] : "?");
+        } else if (c == 'p') {
+            strncat(spec, &c, 1);
+            printf(spec, (void *) (uintptr_t) n);
+        } else if (strchr("fFeEgGaA", c) != nullptr) {
+            double d;
+            memcpy(&d, &n, sizeof d);
+            strncat(spec, &c, 1);
+            printf(spec, d);
+        } else {
+            printf("<%%%c?>", c);
+        }
+    }
+}
+
+void
+DebugRing::Print(const DebugOpts &opts)
+{
+    unsigned long kept = count < size ? count : size;
+    printf("Debug log: last %lu of %lu messages.\n", kept, count);
+
+    for (unsigned long i = count - kept; i < count; i++) {
+        const Entry *e = &entries[i % size];
+        if (!e->cont) {
+            if (opts.location) {
+                printf("[location: %s:%u]\n", e->file, e->line);
+            }
+            if (opts.function) {
+                printf("[function: %s]\n", e->func);
+            }
+            printf("[%c] ", e->flag);
+        }
+        PrintEntry(e);
+    }
+    fflush(stdout);
+    count = 0;
+}
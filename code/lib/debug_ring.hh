@@ -0,0 +1,141 @@
+/// In-memory log of debug messages.
+///
+/// Printing a debug message formats it and writes it to the console, which
+/// is much slower than most of the code that is being traced: with many
+/// flags on, a run takes far longer and the timing of the host gets mixed
+/// up with that of the simulation.  The `ring` debug option (`-do ring`)
+/// keeps messages in memory instead, in binary form: where the message
+/// comes from, the format string, and the arguments as raw words.  Strings
+/// given as arguments are copied, since they may be gone by the time the
+/// message is printed.
+///
+/// The log is a ring: once full, each message takes the place of the
+/// oldest one.  Messages are formatted and printed when the machine halts,
+/// or when an assertion fails.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_LIB_DEBUGRING__HH
+#define NACHOS_LIB_DEBUGRING__HH
+
+
+#include "debug_opts.hh"
+
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+
+class DebugRing {
+public:
+
+    /// Maximum number of arguments of a message.
+    static const unsigned MAX_ARGS = 8;
+
+    /// Bytes available to copy the strings of a message.
+    static const unsigned STRING_BYTES = 48;
+
+    /// Initialize an empty log that keeps the last `size` messages.
+    DebugRing(unsigned size);
+
+    ~DebugRing();
+
+    /// Record a message; `cont` tells whether it continues the previous
+    /// one, without a prefix.
+    template <typename... Args>
+    void Record(const char *file, unsigned line, const char *func,
+                char flag, bool cont, const char *format, Args... args);
+
+    /// Format and print the messages kept, oldest first, and forget them.
+    void Print(const DebugOpts &opts);
+
+private:
+
+    struct Entry {
+        const char *file;
+        const char *func;
+        const char *format;
+        unsigned line;
+        char flag;
+        bool cont;
+        unsigned char numArgs;
+        unsigned char stringsUsed;
+        uint64_t args[MAX_ARGS];
+        char strings[STRING_BYTES];
+    };
+
+    Entry *entries;
+    unsigned size;
+
+    /// Messages recorded so far; the next one goes to `count % size`.
+    unsigned long count;
+
+    Entry *NewEntry(const char *file, unsigned line, const char *func,
+                    char flag, bool cont, const char *format);
+
+    /// Encoding of each kind of argument.
+    static void Encode(Entry *e, unsigned i, const char *s);
+    static void Encode(Entry *e, unsigned i, char *s);
+    static void Encode(Entry *e, unsigned i, double d);
+    static void Encode(Entry *e, unsigned i, float f);
+    template <typename T>
+    static void Encode(Entry *e, unsigned i, T *p);
+    template <typename T>
+    static void Encode(Entry *e, unsigned i, T n);
+
+    static void EncodeAll(Entry *e, unsigned i);
+    template <typename T, typename... Rest>
+    static void EncodeAll(Entry *e, unsigned i, T first, Rest... rest);
+
+    /// Print the text of `e`, its format with the arguments in place.
+    static void PrintEntry(const Entry *e);
+};
+
+
+template <typename... Args>
+void
+DebugRing::Record(const char *file, unsigned line, const char *func,
+                  char flag, bool cont, const char *format, Args... args)
+{
+    static_assert(sizeof... (Args) <= MAX_ARGS,
+                  "too many arguments for a debug message");
+
+    Entry *e = NewEntry(file, line, func, flag, cont, format);
+    e->numArgs = sizeof... (Args);
+    EncodeAll(e, 0, args...);
+}
+
+template <typename T>
+void
+DebugRing::Encode(Entry *e, unsigned i, T *p)
+{
+    e->args[i] = (uintptr_t) p;
+}
+
+/// Integers are kept sign-extended; they are cut back to the size the
+/// format asks for when printed.
+template <typename T>
+void
+DebugRing::Encode(Entry *e, unsigned i, T n)
+{
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+                  "unsupported argument type for a debug message");
+    e->args[i] = (uint64_t) (int64_t) n;
+}
+
+inline void
+DebugRing::EncodeAll(Entry *, unsigned)
+{}
+
+template <typename T, typename... Rest>
+void
+DebugRing::EncodeAll(Entry *e, unsigned i, T first, Rest... rest)
+{
+    Encode(e, i, first);
+    EncodeAll(e, i + 1, rest...);
+}
+
+
+#endif
@@ -0,0 +1,333 @@
+/// A map from keys to values, kept in a hash table.
+///
+/// Items are kept in an array, in the order they were added, and found
+/// through an index: a table of positions in that array, with open
+/// addressing and linear probing.  The index holds small integers and is at
+/// most half full, so a lookup usually touches a cache line or two,
+/// whatever the number of items.  Iterating with `Apply` visits items in
+/// the order they were added, which keeps printed output stable.
+///
+/// Removing an item leaves a hole in the array, and a mark in the index
+/// that lookups go past; both are cleaned up when the table is rebuilt,
+/// once the array is full.
+///
+/// Hashing and comparing keys is done by `HashTraits<Key>`, which is given
+/// for integers and for strings (`const char *`).  String keys are not
+/// copied: they must stay in place while they are in the map.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_LIB_HASHMAP__HH
+#define NACHOS_LIB_HASHMAP__HH
+
+
+#include "utility.hh"
+
+#include <stdint.h>
+#include <string.h>
+
+
+/// Hashing for integer keys.
+template <class Key>
+struct HashTraits {
+    static unsigned Hash(Key key)
+    {
+        // Mix the bits, so that keys that differ only in their high bits,
+        // or that follow a stride, spread over the index.
+        uint64_t h = (uint64_t) key * 0x9E3779B97F4A7C15ull;
+        return (unsigned) (h >> 32);
+    }
+
+    static bool Equal(Key a, Key b)
+    {
+        return a == b;
+    }
+};
+
+/// Hashing for string keys, FNV-1a.
+template <>
+struct HashTraits<const char *> {
+    static unsigned Hash(const char *key)
+    {
+        unsigned h = 2166136261u;
+        for (const char *p = key; *p != '\0'; p++) {
+            h = (h ^ (unsigned char) *p) * 16777619u;
+        }
+        return h;
+    }
+
+    static bool Equal(const char *a, const char *b)
+    {
+        return strcmp(a, b) == 0;
+    }
+};
+
+template <class Key, class Value, class Traits = HashTraits<Key>>
+class HashMap {
+public:
+
+    /// Construct an empty map, with room for `capacity` items before it
+    /// has to grow.
+    HashMap(unsigned capacity = INITIAL_CAPACITY);
+
+    ~HashMap();
+
+    /// Maps own their tables; they cannot be copied.
+    HashMap(const HashMap &) = delete;
+    HashMap &operator=(const HashMap &) = delete;
+
+    /// Associate `value` to `key`, replacing the value it had, if any.
+    ///
+    /// Returns true if the key was not in the map.
+    bool Put(Key key, Value value);
+
+    /// Get the value associated with `key`, or `Value()` if there is none.
+    Value Get(Key key) const;
+
+    /// Check whether `key` has an associated value.
+    bool HasKey(Key key) const;
+
+    /// Remove `key` from the map.
+    ///
+    /// Returns the value it had, or `Value()` if the key was not there.
+    Value Remove(Key key);
+
+    /// Remove every item.
+    void Clear();
+
+    /// Check whether the map is empty.
+    bool IsEmpty() const;
+
+    /// Number of items in the map.
+    unsigned Count() const;
+
+    /// Apply `func` to every item, in the order they were added.  The map
+    /// must not be changed meanwhile.
+    void Apply(void (*func)(Key, Value)) const;
+
+private:
+
+    static const unsigned INITIAL_CAPACITY = 8;
+
+    /// Marks in the index.
+    static const int EMPTY = -1;
+    static const int REMOVED = -2;
+
+    struct Item {
+        Key key;
+        Value value;
+        unsigned hash;
+        bool live;
+    };
+
+    /// Items, in the order they were added; `numItems` of the `capacity`
+    /// entries are taken, `count` of them by live items.
+    Item *items;
+    unsigned capacity;
+    unsigned numItems;
+    unsigned count;
+
+    /// Positions in `items`, or `EMPTY` or `REMOVED`; `indexSize` is a
+    /// power of two, at least twice `capacity`.
+    int *index;
+    unsigned indexSize;
+
+    /// Position in `index` that refers to `key`, or -1 if there is none.
+    int Lookup(Key key, unsigned hash) const;
+
+    /// Rebuild the tables with room for `newCapacity` items, dropping the
+    /// removed ones.
+    void Rebuild(unsigned newCapacity);
+};
+
+
+template <class Key, class Value, class Traits>
+HashMap<Key, Value, Traits>::HashMap(unsigned capacity_)
+{
+    items     = nullptr;
+    index     = nullptr;
+    capacity  = 0;
+    indexSize = 0;
+    numItems  = 0;
+    count     = 0;
+    Rebuild(capacity_ > 0 ? capacity_ : 1);
+}
+
+template <class Key, class Value, class Traits>
+HashMap<Key, Value, Traits>::~HashMap()
+{
+    delete [] items;
+    delete [] index;
+}
+
+template <class Key, class Value, class Traits>
+void
+HashMap<Key, Value, Traits>::Rebuild(unsigned newCapacity)
+{
+    ASSERT(newCapacity >= count);
+
+    unsigned newIndexSize = 2;
+    while (newIndexSize < 2 * newCapacity) {
+        newIndexSize *= 2;
+    }
+
+    Item *newItems = new Item [newCapacity];
+    int *newIndex = new int [newIndexSize];
+    for (unsigned i = 0; i < newIndexSize; i++) {
+        newIndex[i] = EMPTY;
+    }
+
+    unsigned n = 0;
+    for (unsigned i = 0; i < numItems; i++) {
+        if (!items[i].live) {
+            continue;
+        }
+        newItems[n] = items[i];
+        unsigned slot = items[i].hash & (newIndexSize - 1);
+        while (newIndex[slot] != EMPTY) {
+            slot = (slot + 1) & (newIndexSize - 1);
+        }
+        newIndex[slot] = n;
+        n++;
+    }
+
+    delete [] items;
+    delete [] index;
+    items     = newItems;
+    index     = newIndex;
+    capacity  = newCapacity;
+    indexSize = newIndexSize;
+    numItems  = n;
+}
+
+/// The index is never full, even counting removal marks, so the walk ends
+/// at an empty slot.
+template <class Key, class Value, class Traits>
+int
+HashMap<Key, Value, Traits>::Lookup(Key key, unsigned hash) const
+{
+    for (unsigned slot = hash & (indexSize - 1); ;
+         slot = (slot + 1) & (indexSize - 1)) {
+        int i = index[slot];
+        if (i == EMPTY) {
+            return -1;
+        }
+        if (i != REMOVED && items[i].hash == hash
+              && Traits::Equal(items[i].key, key)) {
+            return slot;
+        }
+    }
+}
+
+template <class Key, class Value, class Traits>
+bool
+HashMap<Key, Value, Traits>::Put(Key key, Value value)
+{
+    unsigned hash = Traits::Hash(key);
+    int slot = Lookup(key, hash);
+    if (slot != -1) {
+        items[index[slot]].value = value;
+        return false;
+    }
+
+    if (numItems == capacity) {
+        // Grow only if removed items do not make enough room.
+        Rebuild(count + 1 > capacity / 2 ? 2 * capacity : capacity);
+    }
+
+    unsigned s = hash & (indexSize - 1);
+    while (index[s] >= 0) {
+        s = (s + 1) & (indexSize - 1);
+    }
+    Item *item = &items[numItems];
+    item->key   = key;
+    item->value = value;
+    item->hash  = hash;
+    item->live  = true;
+    index[s] = numItems;
+    numItems++;
+    count++;
+    return true;
+}
+
+template <class Key, class Value, class Traits>
+Value
+HashMap<Key, Value, Traits>::Get(Key key) const
+{
+    int slot = Lookup(key, Traits::Hash(key));
+    return slot != -1 ? items[index[slot]].value : Value();
+}
+
+template <class Key, class Value, class Traits>
+bool
+HashMap<Key, Value, Traits>::HasKey(Key key) const
+{
+    return Lookup(key, Traits::Hash(key)) != -1;
+}
+
+template <class Key, class Value, class Traits>
+Value
+HashMap<Key, Value, Traits>::Remove(Key key)
+{
+    int slot = Lookup(key, Traits::Hash(key));
+    if (slot == -1) {
+        return Value();
+    }
+
+    Item *item = &items[index[slot]];
+    Value value = item->value;
+    item->key   = Key();
+    item->value = Value();
+    item->live  = false;
+    index[slot] = REMOVED;
+    count--;
+    return value;
+}
+
+template <class Key, class Value, class Traits>
+void
+HashMap<Key, Value, Traits>::Clear()
+{
+    for (unsigned i = 0; i < numItems; i++) {
+        items[i].key   = Key();
+        items[i].value = Value();
+        items[i].live  = false;
+    }
+    for (unsigned i = 0; i < indexSize; i++) {
+        index[i] = EMPTY;
+    }
+    numItems = 0;
+    count    = 0;
+}
+
+template <class Key, class Value, class Traits>
+bool
+HashMap<Key, Value, Traits>::IsEmpty() const
+{
+    return count == 0;
+}
+
+template <class Key, class Value, class Traits>
+unsigned
+HashMap<Key, Value, Traits>::Count() const
+{
+    return count;
+}
+
+template <class Key, class Value, class Traits>
+void
+HashMap<Key, Value, Traits>::Apply(void (*func)(Key, Value)) const
+{
+    ASSERT(func != nullptr);
+
+    for (unsigned i = 0; i < numItems; i++) {
+        if (items[i].live) {
+            func(items[i].key, items[i].value);
+        }
+    }
+}
+
+
+#endif
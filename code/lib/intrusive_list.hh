@@ -0,0 +1,299 @@
+/// Data structures for lists whose links live inside the items.
+///
+/// `List` allocates an element to keep track of every item it holds, and
+/// has to walk the list to find an item again.  Objects that are always on
+/// at most one list of a given kind (a thread in a ready or wait queue, a
+/// pending interrupt) can instead embed a `ListLink` and be put on an
+/// `IntrusiveList`, which never allocates and finds, removes and checks an
+/// item in constant time.
+///
+/// The list to use the link for is given as a pointer to member, for
+/// instance:
+///
+///     IntrusiveList<Thread, &Thread::queueLink> readyList;
+///
+/// An object can be on several intrusive lists at once, as long as each
+/// uses a different link.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_LIB_INTRUSIVELIST__HH
+#define NACHOS_LIB_INTRUSIVELIST__HH
+
+
+#include "utility.hh"
+
+
+/// Links of an item in an `IntrusiveList`.
+///
+/// Internal data structures kept public so that `IntrusiveList` operations
+/// can access them directly; nobody else should touch them.
+template <class Item>
+class ListLink {
+public:
+
+    /// Initialize the link as not being on any list.
+    ListLink();
+
+    Item *prev;        ///< Previous item, null if this is the first.
+    Item *next;        ///< Next item, null if this is the last.
+    const void *list;  ///< List the item is on, null if none.
+    int key;           ///< Priority, for a sorted list.
+};
+
+/// A doubly linked list of items that carry their own links, at the member
+/// `LINK`.
+///
+/// The operations are those of `List`, with the same meaning, except that
+/// an item must not be appended to a list while it is on another one
+/// through the same link.
+template <class Item, ListLink<Item> Item::*LINK>
+class IntrusiveList {
+public:
+
+    /// Initialize the list, empty.
+    IntrusiveList();
+
+    /// Take any items left off the list; they are not owned by it, so they
+    /// are not deallocated.
+    ~IntrusiveList();
+
+    /// Put item at the beginning of the list.
+    void Prepend(Item *item);
+
+    /// Put item at the end of the list.
+    void Append(Item *item);
+
+    /// Get the item on the front of the list, which must not be empty.
+    Item *Head() const;
+
+    /// Take item off the front of the list; null if it is empty.
+    Item *Pop();
+
+    /// Take `item`, which must be on the list, off it.
+    void Remove(Item *item);
+
+    /// Apply `func` to all items in the list.
+    void Apply(void (*func)(Item *)) const;
+
+    /// Apply `func` to all items in the list, passing `arg` along.
+    void Apply(void (*func)(Item *, void *), void *arg) const;
+
+    /// Is `item` on this list?
+    bool Has(const Item *item) const;
+
+    /// Is the list empty?
+    bool IsEmpty() const;
+
+    /// Put item into the list, after every item with a key lower or equal
+    /// to `sortKey`.
+    void SortedInsert(Item *item, int sortKey);
+
+    /// Put item into the list, after every item it does not go `before`,
+    /// for lists sorted by something other than an `int` key.
+    void SortedInsert(Item *item, bool (*before)(const Item *, const Item *));
+
+    /// Remove first item from the list, and set `*keyPtr` to its key if
+    /// `keyPtr` is not null.  Return null if the list is empty.
+    Item *SortedPop(int *keyPtr);
+
+private:
+
+    Item *first;  ///< Head of the list, null if list is empty.
+    Item *last;   ///< Last item of the list.
+
+    /// Link `item` between `before` and `after`; either may be null.
+    void Link(Item *item, Item *before, Item *after);
+};
+
+
+template <class Item>
+ListLink<Item>::ListLink()
+{
+    prev = next = nullptr;
+    list = nullptr;
+    key  = 0;
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+IntrusiveList<Item, LINK>::IntrusiveList()
+{
+    first = last = nullptr;
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+IntrusiveList<Item, LINK>::~IntrusiveList()
+{
+    while (!IsEmpty()) {
+        Pop();
+    }
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+void
+IntrusiveList<Item, LINK>::Link(Item *item, Item *before, Item *after)
+{
+    ASSERT(item != nullptr);
+
+    ListLink<Item> *link = &(item->*LINK);
+    ASSERT(link->list == nullptr);
+
+    link->prev = before;
+    link->next = after;
+    link->list = this;
+    if (before != nullptr) {
+        (before->*LINK).next = item;
+    } else {
+        first = item;
+    }
+    if (after != nullptr) {
+        (after->*LINK).prev = item;
+    } else {
+        last = item;
+    }
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+void
+IntrusiveList<Item, LINK>::Prepend(Item *item)
+{
+    (item->*LINK).key = 0;
+    Link(item, nullptr, first);
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+void
+IntrusiveList<Item, LINK>::Append(Item *item)
+{
+    (item->*LINK).key = 0;
+    Link(item, last, nullptr);
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+Item *
+IntrusiveList<Item, LINK>::Head() const
+{
+    ASSERT(!IsEmpty());
+    return first;
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+Item *
+IntrusiveList<Item, LINK>::Pop()
+{
+    return SortedPop(nullptr);
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+void
+IntrusiveList<Item, LINK>::Remove(Item *item)
+{
+    ASSERT(Has(item));
+
+    ListLink<Item> *link = &(item->*LINK);
+    if (link->prev != nullptr) {
+        (link->prev->*LINK).next = link->next;
+    } else {
+        first = link->next;
+    }
+    if (link->next != nullptr) {
+        (link->next->*LINK).prev = link->prev;
+    } else {
+        last = link->prev;
+    }
+    link->prev = link->next = nullptr;
+    link->list = nullptr;
+}
+
+/// The next item is read before calling `func`, so that it may remove the
+/// item it is given.
+template <class Item, ListLink<Item> Item::*LINK>
+void
+IntrusiveList<Item, LINK>::Apply(void (*func)(Item *)) const
+{
+    ASSERT(func != nullptr);
+
+    for (Item *item = first, *next; item != nullptr; item = next) {
+        next = (item->*LINK).next;
+        func(item);
+    }
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+void
+IntrusiveList<Item, LINK>::Apply(void (*func)(Item *, void *),
+                                 void *arg) const
+{
+    ASSERT(func != nullptr);
+
+    for (Item *item = first, *next; item != nullptr; item = next) {
+        next = (item->*LINK).next;
+        func(item, arg);
+    }
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+bool
+IntrusiveList<Item, LINK>::Has(const Item *item) const
+{
+    ASSERT(item != nullptr);
+    return (item->*LINK).list == this;
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+bool
+IntrusiveList<Item, LINK>::IsEmpty() const
+{
+    return first == nullptr;
+}
+
+/// The walk starts from the end of the list: items are most often inserted
+/// later than those already there (interrupts, alarms).
+template <class Item, ListLink<Item> Item::*LINK>
+void
+IntrusiveList<Item, LINK>::SortedInsert(Item *item, int sortKey)
+{
+    Item *before = last;
+    while (before != nullptr && sortKey < (before->*LINK).key) {
+        before = (before->*LINK).prev;
+    }
+    (item->*LINK).key = sortKey;
+    Link(item, before,
+         before != nullptr ? (before->*LINK).next : first);
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+void
+IntrusiveList<Item, LINK>::SortedInsert(Item *item,
+                                        bool (*before)(const Item *,
+                                                       const Item *))
+{
+    ASSERT(before != nullptr);
+
+    Item *prev = last;
+    while (prev != nullptr && before(item, prev)) {
+        prev = (prev->*LINK).prev;
+    }
+    Link(item, prev, prev != nullptr ? (prev->*LINK).next : first);
+}
+
+template <class Item, ListLink<Item> Item::*LINK>
+Item *
+IntrusiveList<Item, LINK>::SortedPop(int *keyPtr)
+{
+    if (IsEmpty()) {
+        return nullptr;
+    }
+
+    Item *item = first;
+    if (keyPtr != nullptr) {
+        *keyPtr = (item->*LINK).key;
+    }
+    Remove(item);
+    return item;
+}
+
+
+#endif
@@ -13,6 +13,7 @@
 
 
 #include "utility.hh"
+#include "slab.hh"
 
 
 /// The following class defines a “list element” -- which is used to keep
@@ -20,6 +21,9 @@
 ///
 /// Internal data structures kept public so that `List` operations can access
 /// them directly.
+///
+/// Elements are allocated on every insertion, so they come from the slab
+/// caches rather than from the host.
 template <class Item>
 class ListElement {
 public:
@@ -30,6 +34,9 @@ public:
     ListElement *next;  ///< Next element on list, null if this is the last.
     int key;            ///< Priority, for a sorted list.
     Item item;          ///< Item on the list.
+
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
 };
 
 /// The following class defines a “list” -- a singly linked list of list
@@ -64,6 +71,9 @@ public:
     /// Apply `func` to all elements in list.
     void Apply(void (*func)(Item));
 
+    /// Apply `func` to all elements in list, passing `arg` along.
+    void Apply(void (*func)(Item, void *), void *arg);
+
     /// Does the list have some item?
     bool Has(Item item) const;
 
@@ -86,6 +96,21 @@ private:
     ListNode *last;   ///< Last element of list.
 };
 
+template <class Item>
+void *
+ListElement<Item>::operator new(size_t size)
+{
+    ASSERT(size == sizeof (ListElement));
+    return SlabAlloc(size);
+}
+
+template <class Item>
+void
+ListElement<Item>::operator delete(void *p)
+{
+    SlabFree(p, sizeof (ListElement));
+}
+
 /// Initialize a list element, so it can be added somewhere on a list.
 ///
 /// * `anItem` is the item to be put on the list.
@@ -230,6 +255,20 @@ List<Item>::Apply(void (*func)(Item))
     }
 }
 
+/// Like the above, for functions that need state of their own.
+///
+/// * `arg` is passed to `func` with every element.
+template <class Item>
+void
+List<Item>::Apply(void (*func)(Item, void *), void *arg)
+{
+    ASSERT(func != nullptr);
+
+    for (ListNode *ptr = first; ptr != nullptr; ptr = ptr->next) {
+        func(ptr->item, arg);
+    }
+}
+
 template <class Item>
 bool
 List<Item>::Has(Item item) const
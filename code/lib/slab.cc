@@ -0,0 +1,193 @@
+/// Routines for the slab allocator.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "slab.hh"
+#include "utility.hh"
+
+#include <new>
+#include <stdio.h>
+
+
+/// Bytes of host memory to ask for at a time, unless objects are larger.
+static const size_t SLAB_BYTES = 8 * 1024;
+
+/// Objects are aligned as the host allocator would.
+static const size_t SLAB_ALIGN = alignof (max_align_t);
+
+/// Every cache that was constructed.  Being a plain pointer, it is set
+/// before any static cache is constructed.
+SlabCache *SlabCache::allCaches = nullptr;
+
+static size_t
+RoundUp(size_t n, size_t multiple)
+{
+    return (n + multiple - 1) / multiple * multiple;
+}
+
+SlabCache::SlabCache(const char *name_, size_t objectSize_)
+{
+    ASSERT(name_ != nullptr);
+    ASSERT(objectSize_ > 0);
+
+    name       = name_;
+    objectSize = RoundUp(objectSize_ < sizeof (FreeObject)
+                           ? sizeof (FreeObject) : objectSize_,
+                         SLAB_ALIGN);
+    size_t header = RoundUp(sizeof (Slab), SLAB_ALIGN);
+    objectsPerSlab = objectSize * 8 <= SLAB_BYTES - header
+                     ? (SLAB_BYTES - header) / objectSize : 8;
+
+    slabs       = nullptr;
+    freeObjects = nullptr;
+    numSlabs    = 0;
+    inUse       = peakInUse = 0;
+    allocs      = frees = 0;
+
+    nextCache = allCaches;
+    allCaches = this;
+}
+
+SlabCache::~SlabCache()
+{
+    // Unlink from the list of caches.
+    for (SlabCache **c = &allCaches; *c != nullptr; c = &(*c)->nextCache) {
+        if (*c == this) {
+            *c = nextCache;
+            break;
+        }
+    }
+
+    if (inUse > 0) {
+        return;  // Leave them be; the process is most likely exiting.
+    }
+    while (slabs != nullptr) {
+        Slab *slab = slabs;
+        slabs = slab->next;
+        ::operator delete(slab);
+    }
+}
+
+void
+SlabCache::Grow()
+{
+    size_t header = RoundUp(sizeof (Slab), SLAB_ALIGN);
+    char *memory = (char *) ::operator new(header
+                                           + objectsPerSlab * objectSize);
+    Slab *slab = new (memory) Slab;
+    slab->next = slabs;
+    slabs = slab;
+    numSlabs++;
+
+    // Link the objects in address order, so that they are handed out in
+    // that order.
+    for (unsigned i = objectsPerSlab; i > 0; i--) {
+        FreeObject *object
+          = new (memory + header + (i - 1) * objectSize) FreeObject;
+        object->next = freeObjects;
+        freeObjects = object;
+    }
+}
+
+void *
+SlabCache::Alloc()
+{
+    if (freeObjects == nullptr) {
+        Grow();
+    }
+    FreeObject *object = freeObjects;
+    freeObjects = object->next;
+
+    allocs++;
+    inUse++;
+    if (inUse > peakInUse) {
+        peakInUse = inUse;
+    }
+    return object;
+}
+
+void
+SlabCache::Free(void *p)
+{
+    if (p == nullptr) {
+        return;
+    }
+    ASSERT(inUse > 0);
+
+    FreeObject *object = new (p) FreeObject;
+    object->next = freeObjects;
+    freeObjects = object;
+
+    frees++;
+    inUse--;
+}
+
+void
+SlabCache::Print() const
+{
+    printf("  %-20s %5zu bytes, %4u in use (peak %4u), %3u slabs, "
+           "%lu allocs, %lu frees\n", name, objectSize, inUse, peakInUse,
+           numSlabs, allocs, frees);
+}
+
+void
+SlabCache::PrintAll()
+{
+    printf("Slab caches:\n");
+    for (SlabCache *c = allCaches; c != nullptr; c = c->nextCache) {
+        if (c->allocs > 0) {
+            c->Print();
+        }
+    }
+}
+
+static const unsigned NUM_SIZE_CACHES = 9;
+
+/// Cache for `size` bytes, which must be at most `SLAB_MAX_SIZE`.
+///
+/// The caches are built on first use, since objects may be allocated by the
+/// initializers of other static objects.
+static SlabCache *
+SizeCache(size_t size)
+{
+    static SlabCache caches[NUM_SIZE_CACHES] = {
+        { "size-16", 16 },
+        { "size-32", 32 },
+        { "size-64", 64 },
+        { "size-128", 128 },
+        { "size-256", 256 },
+        { "size-512", 512 },
+        { "size-1024", 1024 },
+        { "size-2048", 2048 },
+        { "size-4096", 4096 },
+    };
+
+    unsigned i = 0;
+    for (size_t fits = 16; fits < size; fits *= 2) {
+        i++;
+    }
+    ASSERT(i < NUM_SIZE_CACHES);
+    return &caches[i];
+}
+
+void *
+SlabAlloc(size_t size)
+{
+    if (size > SLAB_MAX_SIZE) {
+        return ::operator new(size);
+    }
+    return SizeCache(size)->Alloc();
+}
+
+void
+SlabFree(void *p, size_t size)
+{
+    if (size > SLAB_MAX_SIZE) {
+        ::operator delete(p);
+        return;
+    }
+    SizeCache(size)->Free(p);
+}
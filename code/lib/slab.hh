@@ -0,0 +1,109 @@
+/// A slab allocator for kernel objects.
+///
+/// The kernel creates and destroys some objects all the time: file headers
+/// and directories on every file system operation, pending interrupts on
+/// every device request, list elements on every insertion, sector buffers
+/// on every read and write.  Going to the host allocator for each of them
+/// is slow, so they come from caches instead.
+///
+/// A `SlabCache` hands out objects of one size.  It gets memory from the
+/// host a slab at a time, carves it into objects, and keeps freed objects
+/// in a list to hand them out again.  Memory is not given back to the host
+/// while the cache lives: a cache holds as many objects as were ever in use
+/// at once.
+///
+/// Classes use a cache of their own through class-level `operator new` and
+/// `operator delete`.  The cache is a static object local to a function, so
+/// that it is built on first use: some kernel objects are created by the
+/// initializers of other static objects.  Buffers and other objects of
+/// varying size go through `SlabAlloc` and `SlabFree`, which pick among
+/// caches of power-of-two sizes.
+///
+/// Every cache keeps usage counters; the `slab` debug option (`-do slab`)
+/// prints them when the machine halts.
+///
+/// Caches are not synchronized: like the rest of the kernel's data, they
+/// rely on interrupts not arriving in the middle of host code.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_LIB_SLAB__HH
+#define NACHOS_LIB_SLAB__HH
+
+
+#include <stddef.h>
+
+
+class SlabCache {
+public:
+
+    /// Initialize an empty cache of objects of `objectSize` bytes, called
+    /// `name` in reports.
+    SlabCache(const char *name, size_t objectSize);
+
+    /// Give the slabs back to the host, unless objects are still in use.
+    ~SlabCache();
+
+    /// Caches know where they are; they cannot be copied.
+    SlabCache(const SlabCache &) = delete;
+    SlabCache &operator=(const SlabCache &) = delete;
+
+    /// Get an object.  Never fails.
+    void *Alloc();
+
+    /// Return an object obtained from `Alloc`.  Null is ignored.
+    void Free(void *object);
+
+    /// Print usage counters.
+    void Print() const;
+
+    /// Print the counters of every cache that has been used.
+    static void PrintAll();
+
+private:
+
+    /// A free object; its storage is reused as the link to the next one.
+    struct FreeObject {
+        FreeObject *next;
+    };
+
+    /// Header at the start of every slab.
+    struct Slab {
+        Slab *next;
+    };
+
+    const char *name;
+    size_t objectSize;
+    unsigned objectsPerSlab;
+
+    Slab *slabs;
+    FreeObject *freeObjects;
+
+    /// Usage counters.
+    unsigned numSlabs;
+    unsigned inUse, peakInUse;
+    unsigned long allocs, frees;
+
+    /// Every cache, for `PrintAll`.
+    SlabCache *nextCache;
+    static SlabCache *allCaches;
+
+    /// Get another slab from the host and add its objects to the free
+    /// list.
+    void Grow();
+};
+
+/// Largest size served by `SlabAlloc`; larger requests go to the host.
+const size_t SLAB_MAX_SIZE = 4096;
+
+/// Get `size` bytes, from the cache of the smallest power of two that fits.
+void *SlabAlloc(size_t size);
+
+/// Return memory obtained from `SlabAlloc`; `size` must be the same as
+/// requested.
+void SlabFree(void *p, size_t size);
+
+
+#endif
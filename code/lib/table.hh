@@ -1,5 +1,16 @@
 /// A very simple map from non-negative integers to some type.
 ///
+/// The table hands out the integers itself, as ids for the items added to
+/// it.  Items live in an array of slots that grows as needed, up to a
+/// maximum given on construction, and free slots are kept in a list, so
+/// adding and removing items take constant time.
+///
+/// An id carries, besides the index of its slot, the generation of the
+/// slot, which changes every time an item is removed from it.  So an id
+/// kept after its item was removed is not valid anymore, even once the
+/// slot holds another item.  Ids are never negative; generations wrap
+/// around after `MAX_GENERATION` reuses of a slot.
+///
 /// Copyright (c) 2018-2021 Docentes de la Universidad Nacional de Rosario.
 /// All rights reserved.  See `copyright.h` for copyright notice and
 /// limitation of liability and disclaimer of warranty provisions.
@@ -8,143 +19,235 @@
 #define NACHOS_LIB_TABLE__HH
 
 
-#include "list.hh"
+#include "utility.hh"
 
 
 template <class T>
 class Table {
 public:
-    static const unsigned SIZE = 20;
 
-    /// Construct an empty table.
-    Table();
+    /// Number of bits of an id that hold the slot index.
+    static const unsigned INDEX_BITS = 16;
+
+    /// Largest table possible.
+    static const unsigned MAX_SIZE = 1 << INDEX_BITS;
+
+    /// Slot generations go from 0 to this.
+    static const unsigned MAX_GENERATION = (1u << (31 - INDEX_BITS)) - 1;
+
+    /// Construct an empty table that holds at most `maxSize` items.
+    Table(unsigned maxSize = MAX_SIZE);
+
+    ~Table();
 
-    /// Add an item into a free index.
+    /// Add an item into a free slot.
     ///
-    /// Returns -1 if no space is left to add the item.
+    /// Returns its id, or -1 if the table is full.
     int Add(T item);
 
-    /// Get the item associated with a given index.
-    T Get(int i) const;
+    /// Get the item associated with a given id, or `T()` if there is none.
+    T Get(int id) const;
 
-    /// Check whether a given index has an associated item.
-    bool HasKey(int i) const;
+    /// Check whether a given id has an associated item.  Any id may be
+    /// given, even negative or stale ones.
+    bool HasKey(int id) const;
 
     /// Check whether the table is empty.
     bool IsEmpty() const;
 
-    /// Remove the item associated with a given index.
+    /// Number of items in the table.
+    unsigned Count() const;
+
+    /// Remove the item associated with a given id.
     ///
-    /// Returns the removed item, or `T()` if the index is already
-    /// unoccupied.
-    T Remove(int i);
+    /// Returns the removed item, or `T()` if the id has no item.
+    T Remove(int id);
 
-    /// Updates the item associated with a given valid index.
+    /// Updates the item associated with a given valid id.
     ///
-    /// The index must be valid, i.e. it must be assigned to some value.
+    /// The id must be valid, i.e. it must be assigned to some value.
     ///
     /// Returns the old item.
-    T Update(int i, T item);
+    T Update(int id, T item);
 
 private:
-    /// Data items.
-    T data[SIZE];
 
-    /// Current greatest index for a new item.
-    int current;
+    /// Number of slots allocated at first.
+    static const unsigned INITIAL_SLOTS = 8;
+
+    struct Slot {
+        T item;
+        unsigned generation;
+        bool used;
+        int nextFree;  ///< Next free slot, -1 if this is the last one.
+    };
+
+    /// Slot storage; `numSlots` entries, at most `maxSize`.
+    Slot *slots;
+    unsigned numSlots;
+    unsigned maxSize;
+
+    /// Number of slots in use.
+    unsigned count;
+
+    /// First free slot, -1 if every slot is used.
+    int firstFree;
+
+    /// Make room for more slots, if the maximum allows.
+    void Grow();
 
-    /// A list to store indexes of items that have been freed and are not
-    /// among those with greatest numbers, so it is not possible to modify
-    /// `current`.  In other words, this keeps track of external
-    /// fragmentation.
-    List<int> freed;
+    /// Index of the slot of a valid `id`, or -1 if it is not valid.
+    int SlotOf(int id) const;
 };
 
 
 template <class T>
-Table<T>::Table()
+Table<T>::Table(unsigned maxSize_)
 {
-    current = 0;
+    ASSERT(maxSize_ > 0 && maxSize_ <= MAX_SIZE);
+
+    maxSize   = maxSize_;
+    slots     = nullptr;
+    numSlots  = 0;
+    count     = 0;
+    firstFree = -1;
+}
+
+template <class T>
+Table<T>::~Table()
+{
+    delete [] slots;
+}
+
+/// Double the slots, and put the new ones in the free list in order, so
+/// that low indexes are handed out first.
+template <class T>
+void
+Table<T>::Grow()
+{
+    ASSERT(firstFree == -1);
+
+    if (numSlots == maxSize) {
+        return;
+    }
+    unsigned newNumSlots = numSlots == 0 ? INITIAL_SLOTS : 2 * numSlots;
+    if (newNumSlots > maxSize) {
+        newNumSlots = maxSize;
+    }
+
+    Slot *newSlots = new Slot [newNumSlots];
+    for (unsigned i = 0; i < numSlots; i++) {
+        newSlots[i] = slots[i];
+    }
+    for (unsigned i = numSlots; i < newNumSlots; i++) {
+        newSlots[i].item       = T();
+        newSlots[i].generation = 0;
+        newSlots[i].used       = false;
+        newSlots[i].nextFree   = i + 1 < newNumSlots ? (int) i + 1 : -1;
+    }
+    firstFree = numSlots;
+
+    delete [] slots;
+    slots    = newSlots;
+    numSlots = newNumSlots;
 }
 
+template <class T>
+int
+Table<T>::SlotOf(int id) const
+{
+    if (id < 0) {
+        return -1;
+    }
+    unsigned i = (unsigned) id & (MAX_SIZE - 1);
+    unsigned generation = (unsigned) id >> INDEX_BITS;
+    if (i >= numSlots || !slots[i].used
+          || slots[i].generation != generation) {
+        return -1;
+    }
+    return i;
+}
 
 template <class T>
 int
 Table<T>::Add(T item)
 {
-    int i;
-    
-    if (!freed.IsEmpty()) {
-        i = freed.Pop();
-        data[i] = item;
-        return i;
-    } else if (current < static_cast<int>(SIZE)) {
-        i = current++;
-        data[i] = item;
-        return i;
-    } else {
-        return -1;
+    if (firstFree == -1) {
+        Grow();
+        if (firstFree == -1) {
+            return -1;
+        }
     }
+
+    unsigned i = firstFree;
+    Slot *slot = &slots[i];
+    firstFree      = slot->nextFree;
+    slot->item     = item;
+    slot->used     = true;
+    slot->nextFree = -1;
+    count++;
+    return (int) (slot->generation << INDEX_BITS | i);
 }
 
 template <class T>
 T
-Table<T>::Get(int i) const
+Table<T>::Get(int id) const
 {
-    ASSERT(i >= 0);
-
-    return HasKey(i) ? data[i] : T();
+    int i = SlotOf(id);
+    return i != -1 ? slots[i].item : T();
 }
 
 template <class T>
 bool
-Table<T>::HasKey(int i) const
+Table<T>::HasKey(int id) const
 {
-    ASSERT(i >= 0);
-
-    return i < current && !freed.Has(i);
+    return SlotOf(id) != -1;
 }
 
 template <class T>
 bool
 Table<T>::IsEmpty() const
 {
-    return current == 0;
+    return count == 0;
 }
 
 template <class T>
-T
-Table<T>::Remove(int i)
+unsigned
+Table<T>::Count() const
 {
-    ASSERT(i >= 0);
+    return count;
+}
 
-    if (!HasKey(i)) {
+template <class T>
+T
+Table<T>::Remove(int id)
+{
+    int i = SlotOf(id);
+    if (i == -1) {
         return T();
     }
 
-    if (i == current - 1) {
-        current--;
-        for (int j = current - 1; j >= 0 && !HasKey(j); j--) {
-            ASSERT(freed.Has(j));
-            freed.Remove(j);
-            current--;
-        }
-    } else {
-        freed.SortedInsert(i, i);
-    }
-    return data[i];
+    Slot *slot = &slots[i];
+    T item = slot->item;
+    slot->item       = T();
+    slot->used       = false;
+    slot->generation = slot->generation == MAX_GENERATION
+                       ? 0 : slot->generation + 1;
+    slot->nextFree   = firstFree;
+    firstFree        = i;
+    count--;
+    return item;
 }
 
 template <class T>
 T
-Table<T>::Update(int i, T item)
+Table<T>::Update(int id, T item)
 {
-    ASSERT(i >= 0);
-    ASSERT(i < current);
-    ASSERT(!freed.Has(i));
+    int i = SlotOf(id);
+    ASSERT(i != -1);
 
-    T previous = data[i];
-    data[i] = item;
+    T previous = slots[i].item;
+    slots[i].item = item;
     return previous;
 }
 
@@ -14,6 +14,8 @@
 #include "assert.hh"
 #include "debug.hh"
 
+#include <type_traits>
+
 
 /// Useful definitions for diverse data structures.
 
@@ -66,8 +68,21 @@ typedef void (*VoidNoArgFunctionPtr)();
 /// Global object for debug output.
 extern Debug debug;
 
-#define DEBUG(...)  (debug.Print)(__FILE__, __LINE__, __func__, __VA_ARGS__)
-#define DEBUG_CONT  (debug.PrintCont)
+/// Print a debug message, see `Debug::Print`.
+///
+/// Messages of flags not compiled in (see `debug.hh`) are discarded at
+/// compile time; those compiled in are checked before their arguments are
+/// passed.
+#define DEBUG(flag, ...) \
+    (std::integral_constant<bool, DebugCompiled(flag)>::value \
+       && debug.IsEnabled(flag) \
+     ? debug.Print(__FILE__, __LINE__, __func__, flag, __VA_ARGS__) \
+     : (void) 0)
+#define DEBUG_CONT(flag, ...) \
+    (std::integral_constant<bool, DebugCompiled(flag)>::value \
+       && debug.IsEnabled(flag) \
+     ? debug.PrintCont(flag, __VA_ARGS__) \
+     : (void) 0)
 
 
 #endif
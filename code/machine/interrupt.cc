@@ -22,6 +22,7 @@
 
 #include "interrupt.hh"
 #include "threads/system.hh"
+#include "lib/slab.hh"
 
 #include <limits.h>
 #include <stdio.h>
@@ -31,7 +32,7 @@
 
 static const char *INT_LEVEL_NAMES[] = { "disabled", "enabled" };
 static const char *INT_TYPE_NAMES[]  = {
-    "timer", "disk", "console write", "console read"
+    "timer", "disk", "console write", "console read", "alarm"
 };
 
 static inline bool
@@ -65,13 +66,35 @@ PendingInterrupt::PendingInterrupt(VoidFunctionPtr func, void *param,
     type    = kind;
 }
 
+/// Cache for `PendingInterrupt` objects, built on first use.
+static SlabCache &
+PendingInterruptCache()
+{
+    static SlabCache cache("PendingInterrupt", sizeof (PendingInterrupt));
+    return cache;
+}
+
+void *
+PendingInterrupt::operator new(size_t size)
+{
+    ASSERT(size == sizeof (PendingInterrupt));
+    return PendingInterruptCache().Alloc();
+}
+
+void
+PendingInterrupt::operator delete(void *p)
+{
+    PendingInterruptCache().Free(p);
+}
+
 /// Initialize the simulation of hardware device interrupts.
 ///
 /// Interrupts start disabled, with no interrupts pending, etc.
 Interrupt::Interrupt()
 {
     level         = INT_OFF;
-    pending       = new List<PendingInterrupt *>;
+    pending       = new IntrusiveList<PendingInterrupt,
+                                    &PendingInterrupt::link>;
     inHandler     = false;
     yieldOnReturn = false;
     status        = SYSTEM_MODE;
@@ -224,11 +247,34 @@ Interrupt::Halt()
 {
     printf("Machine halting!\n\n");
     stats->Print();
+#ifdef SWAP
+    coreMap->Print();
+    if (pageoutDaemon != nullptr) {
+        pageoutDaemon->Print();
+    }
+#endif
+    if (lockProfiler != nullptr) {
+        lockProfiler->Print();
+    }
+    if (lockDep != nullptr) {
+        lockDep->Print();
+    }
+    if (schedStats != nullptr) {
+        schedStats->Report();
+    }
+    if (debug.GetOpts().slabStats) {
+        SlabCache::PrintAll();
+    }
+    if (debug.GetOpts().poolStats && threadPool != nullptr) {
+        threadPool->Print();
+    }
+    debug.PrintRing();
     Cleanup();  // Never returns.
 }
 
 #ifdef DFS_TICKS_FIX
-/// Restart the total ticks statistic and the pending interrupts list.
+/// Restart the total ticks statistic, the pending interrupts list and the
+/// wake up times of sleeping threads.
 ///
 /// This function makes sure Nachos keeps working even after overflowing the
 /// tick counter.  After some time (when `totalTicks` reach the maximum
@@ -237,19 +283,26 @@ Interrupt::Halt()
 void
 Interrupt::RestartTicks()
 {
-    List<PendingInterrupt *> *oldPending = pending;
-    pending = new List<PendingInterrupt *>;
+    IntrusiveList<PendingInterrupt, &PendingInterrupt::link> *oldPending
+      = pending;
+    pending = new IntrusiveList<PendingInterrupt, &PendingInterrupt::link>;
 
+    // Both the due time and the sort key are moved, as `CheckIfDue` reads
+    // the former.  An interrupt already due stays due.
     PendingInterrupt *i;
-    unsigned          oldWhen = 0;
-    while ((i = oldPending->SortedPop((int *) &oldWhen)) != nullptr) {
-        unsigned newWhen = oldWhen - stats->totalTicks;
-        pending->SortedInsert(i, newWhen);
-        DEBUG('x', "Interrupt at time %u re-scheduled at new time %u.\n",
-              oldWhen, newWhen);
+    while ((i = oldPending->Pop()) != nullptr) {
+        unsigned long oldWhen = i->when;
+        i->when = oldWhen > stats->totalTicks ? oldWhen - stats->totalTicks
+                                              : 0;
+        pending->SortedInsert(i, i->when);
+        DEBUG('x', "Interrupt at time %lu re-scheduled at new time %lu.\n",
+              oldWhen, i->when);
     }
 
     delete oldPending;
+    if (sleepQueue != nullptr) {
+        sleepQueue->Rebase(stats->totalTicks);
+    }
     stats->totalTicks = 0;
     stats->tickResets += 1;
 }
@@ -316,19 +369,18 @@ Interrupt::CheckIfDue(bool advanceClock)
     if (debug.IsEnabled('i')) {
         DumpState();
     }
-    PendingInterrupt *toOccur = pending->SortedPop((int *) &when);
-
-    if (toOccur == nullptr) {  // No pending interrupts.
+    if (pending->IsEmpty()) {  // No pending interrupts.
         return false;
     }
+    when = pending->Head()->when;
 
     if (advanceClock && when > stats->totalTicks) {  // Advance the clock.
         stats->idleTicks += (when - stats->totalTicks);
         stats->totalTicks = when;
-    } else if (when > stats->totalTicks) {  // Not time yet, put it back.
-        pending->SortedInsert(toOccur, when);
+    } else if (when > stats->totalTicks) {  // Not time yet, leave it.
         return false;
     }
+    PendingInterrupt *toOccur = pending->Pop();
 
     // Check if there is nothing more to do, and if so, quit.
     if (status == IDLE_MODE && toOccur->type == TIMER_INT
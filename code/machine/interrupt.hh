@@ -36,7 +36,7 @@
 #define NACHOS_MACHINE_INTERRUPT__HH
 
 
-#include "lib/list.hh"
+#include "lib/intrusive_list.hh"
 
 
 /// Interrupts can be disabled (`INT_OFF`) or enabled (`INT_ON`).
@@ -64,6 +64,7 @@ enum IntType {
     DISK_INT,
     CONSOLE_WRITE_INT,
     CONSOLE_READ_INT,
+    ALARM_INT,  ///< Wake up sleeping threads.
     NUM_INT_TYPES
 };
 
@@ -79,12 +80,17 @@ public:
     PendingInterrupt(VoidFunctionPtr func, void *param,
                      unsigned long time, IntType kind);
 
+    /// Pending interrupts come from a slab cache.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     VoidFunctionPtr handler;  ///< The function (in the hardware device
                               ///< emulator) to call when the interrupt
                               ///< occurs.
     void *arg;  ///< The argument to the function.
     unsigned long when;  ///< When the interrupt is supposed to fire.
     IntType type;  ///< For debugging.
+    ListLink<PendingInterrupt> link;  ///< Link in the pending list.
 };
 
 /// The following class defines the data structures for the simulation
@@ -145,8 +151,8 @@ public:
 
 private:
     IntStatus level;  ///< Are interrupts enabled or disabled?
-    List<PendingInterrupt *> *pending;  ///< The list of interrupts scheduled
-                                        ///< to occur in the future.
+    /// The list of interrupts scheduled to occur in the future.
+    IntrusiveList<PendingInterrupt, &PendingInterrupt::link> *pending;
     bool inHandler;  ///< True if we are running an interrupt handler.
     bool yieldOnReturn;  ///< True if we are to context switch on return from
                          ///< the interrupt handler.
@@ -20,7 +20,8 @@ Statistics::Statistics()
     totalTicks = idleTicks = systemTicks = userTicks = 0;
     numDiskReads = numDiskWrites = 0;
     numConsoleCharsRead = numConsoleCharsWritten = 0;
-    numPageFaults = 0;
+    numPageFaults = numPrefetchedPages = numSwappedPages = numSwapReads = 0;
+    tlbHits = tlbTries = 0;
 #ifdef DFS_TICKS_FIX
     tickResets = 0;
 #endif
@@ -43,7 +44,16 @@ Statistics::Print()
     printf("Disk I/O: reads %lu, writes %lu\n", numDiskReads, numDiskWrites);
     printf("Console I/O: reads %lu, writes %lu\n",
            numConsoleCharsRead, numConsoleCharsWritten);
+#ifdef USER_PROGRAM
     printf("Paging: faults %lu, hits %lu, total %lu, ratio %f.\n",
             numPageFaults, tlbHits, tlbTries,
-            (double) tlbHits / (double) tlbTries);
+            tlbTries != 0 ? (double) tlbHits / (double) tlbTries : 0.0);
+#endif
+#ifdef DEMAND_LOADING
+    printf("Prefetch: pages loaded ahead %lu\n", numPrefetchedPages);
+#endif
+#ifdef SWAP
+    printf("Swap: pages written %lu, read %lu\n",
+           numSwappedPages, numSwapReads);
+#endif
 }
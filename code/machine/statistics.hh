@@ -46,8 +46,13 @@ public:
 
     /// Number of virtual memory page faults.
     unsigned long numPageFaults;
+
+    /// Number of pages loaded before they were asked for.
+    unsigned long numPrefetchedPages;
     
+    /// Number of pages written to and read from swap.
     unsigned long numSwappedPages;
+    unsigned long numSwapReads;
 
     unsigned long tlbHits;
     unsigned long tlbTries;
@@ -395,4 +395,110 @@ DeallocBoundedArray(const char *ptr, unsigned size)
     delete [] (ptr - pgSize);
 }
 
+/// Return an array whose lowest page is a guard page mapped with no access
+/// rights, so that running off the bottom of the array faults immediately.
+///
+/// Thread stacks grow downwards, so the guard page catches stack overflows
+/// at the instruction that causes them, instead of relying on a fencepost
+/// being checked at the next context switch.
+///
+/// The array is mapped directly from the host, so it is page aligned and
+/// its size is rounded up to a whole number of pages.  Pages are only
+/// committed by the host when they are first touched.
+///
+/// Note: just return the useful part!
+///
+/// * `size` -- amount of useful space needed (in bytes).
+/// * `reserveOnly` -- do not account the array against the host's swap
+///   space either; meant for large arrays of which only a small part is
+///   expected to be used.
+char *
+AllocGuardedArray(unsigned size, bool reserveOnly)
+{
+    ASSERT(size > 0);
+
+    size_t pgSize = getpagesize();
+    size_t length = pgSize + DivRoundUp<size_t>(size, pgSize) * pgSize;
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    if (reserveOnly) {
+        flags |= MAP_NORESERVE;
+    }
+#endif
+
+    void *ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE,
+                     flags, -1, 0);
+    ASSERT(ptr != MAP_FAILED);
+    ASSERT(mprotect(ptr, pgSize, PROT_NONE) == 0);
+
+    return (char *) ptr + pgSize;
+}
+
+/// Deallocate an array obtained through `AllocGuardedArray`, together with
+/// its guard page.
+///
+/// * `ptr` is the array to be deallocated.
+/// * `size` is the amount of useful space in the array (in bytes).
+void
+DeallocGuardedArray(const char *ptr, unsigned size)
+{
+    ASSERT(ptr != nullptr);
+    ASSERT(size > 0);
+
+    size_t pgSize = getpagesize();
+    size_t length = pgSize + DivRoundUp<size_t>(size, pgSize) * pgSize;
+
+    munmap((void *) (ptr - pgSize), length);
+}
+
+/// Give the host memory backing part of a guarded array back, keeping the
+/// mapping.  The discarded part reads as zeroes the next time it is
+/// touched.
+///
+/// * `ptr` is the start of the part to discard; it must be page aligned.
+/// * `size` is the amount of bytes to discard, rounded down to whole pages.
+void
+DiscardArray(char *ptr, unsigned size)
+{
+    ASSERT(ptr != nullptr);
+
+    size_t pgSize = getpagesize();
+    size_t length = DivRoundDown<size_t>(size, pgSize) * pgSize;
+
+    if (length > 0) {
+        madvise(ptr, length, MADV_DONTNEED);
+    }
+}
+
+/// Return how deep, in bytes, a downward-growing guarded array (such as a
+/// thread stack) has been used, judging by which of its pages the host has
+/// committed.
+///
+/// The result is rounded up to whole pages.
+///
+/// * `ptr` is the array, as returned by `AllocGuardedArray`.
+/// * `size` is the amount of useful space in the array (in bytes).
+unsigned
+ResidentDepth(const char *ptr, unsigned size)
+{
+    ASSERT(ptr != nullptr);
+    ASSERT(size > 0);
+
+    size_t pgSize   = getpagesize();
+    size_t numPages = DivRoundUp<size_t>(size, pgSize);
+    unsigned char *resident = new unsigned char [numPages];
+    unsigned depth = 0;
+
+    if (mincore((void *) ptr, numPages * pgSize, resident) == 0) {
+        for (size_t i = 0; i < numPages; i++) {
+            if (resident[i] & 1) {
+                depth = (numPages - i) * pgSize;
+                break;
+            }
+        }
+    }
+    delete [] resident;
+    return depth;
+}
+
 };
@@ -64,6 +64,21 @@ namespace SystemDep {
     char *AllocBoundedArray(unsigned size);
 
     void DeallocBoundedArray(const char *p, unsigned size);
+
+    /// Allocate, de-allocate an array preceded by an inaccessible guard
+    /// page, such that de-referencing just below the array causes an error.
+    ///
+    /// The host commits memory for the array lazily, as it gets touched.
+
+    char *AllocGuardedArray(unsigned size, bool reserveOnly = false);
+
+    void DeallocGuardedArray(const char *p, unsigned size);
+
+    /// Release the host memory behind part of a guarded array.
+    void DiscardArray(char *p, unsigned size);
+
+    /// How deep a downward-growing guarded array has been touched.
+    unsigned ResidentDepth(const char *p, unsigned size);
 };
 
 
@@ -0,0 +1,97 @@
+/// Routines for barriers.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "barrier.hh"
+#include "system.hh"
+
+#include <stdio.h>
+
+
+Barrier::Barrier(const char *debugName, unsigned parties_)
+{
+    ASSERT(parties_ > 0);
+
+    name       = debugName;
+    parties    = parties_;
+    arrived    = 0;
+    generation = 0;
+    waiters    = new WaitQueue;
+    waits = totalWaitTicks = maxWaitTicks = 0;
+    DEBUG('s', "Barrier %s created by %p\n", name, currentThread);
+}
+
+Barrier::~Barrier()
+{
+    ASSERT(waiters->IsEmpty());
+
+    DEBUG('s', "Barrier %s: %u generations, %lu waits, "
+               "%lu ticks waited (max %lu)\n",
+          name, generation, waits, totalWaitTicks, maxWaitTicks);
+    delete waiters;
+}
+
+const char *
+Barrier::GetName() const
+{
+    return name;
+}
+
+unsigned
+Barrier::GetParties() const
+{
+    return parties;
+}
+
+unsigned
+Barrier::GetGeneration() const
+{
+    return generation;
+}
+
+bool
+Barrier::Wait()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    bool last = ++arrived == parties;
+    if (last) {
+        // Release the whole generation at once.
+        arrived = 0;
+        generation++;
+        Thread *thread;
+        while ((thread = waiters->Pop()) != nullptr) {
+            scheduler->ReadyToRun(thread);
+        }
+        DEBUG('s', "Barrier %s: generation %u complete\n", name, generation);
+    } else {
+        unsigned long start = stats->totalTicks;
+        unsigned myGeneration = generation;
+        while (generation == myGeneration) {
+            waiters->Append(currentThread);
+            currentThread->Sleep();
+        }
+
+        unsigned long waited = stats->totalTicks - start;
+        waits++;
+        totalWaitTicks += waited;
+        if (waited > maxWaitTicks) {
+            maxWaitTicks = waited;
+        }
+    }
+
+    interrupt->SetLevel(oldLevel);
+    return last;
+}
+
+void
+Barrier::Print() const
+{
+    printf("Barrier %s: %u parties, %u arrived, %u generations\n",
+           name, parties, arrived, generation);
+    printf("    waits: %lu, ticks waited: %lu total, %lu max\n",
+           waits, totalWaitTicks, maxWaitTicks);
+}
@@ -0,0 +1,69 @@
+/// Barriers, a synchronization primitive
+///
+/// A barrier makes a fixed number of threads, its *parties*, wait for each
+/// other: every thread calling `Wait` blocks until all the parties have
+/// called it, and then all of them go on at once.
+///
+/// Barriers are reusable: once every party has arrived, a new *generation*
+/// starts and the barrier can be waited on again, which suits work split
+/// into phases.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_BARRIER__HH
+#define NACHOS_THREADS_BARRIER__HH
+
+
+#include "wait_queue.hh"
+
+
+class Barrier {
+public:
+
+    /// Constructor: set up a barrier for `parties` threads.
+    Barrier(const char *debugName, unsigned parties);
+
+    /// Assume no one is waiting on the barrier.
+    ~Barrier();
+
+    /// For debugging.
+    const char *GetName() const;
+
+    unsigned GetParties() const;
+
+    /// Number of generations completed so far.
+    unsigned GetGeneration() const;
+
+    /// Wait until every party has arrived.
+    ///
+    /// Return `true` in exactly one thread per generation, the last one to
+    /// arrive, which may be used to run code once per phase.
+    bool Wait();
+
+    /// Print wait statistics.
+    void Print() const;
+
+private:
+
+    /// For debugging.
+    const char *name;
+
+    unsigned parties;
+
+    /// Threads that have arrived in the current generation.
+    unsigned arrived;
+
+    unsigned generation;
+
+    WaitQueue *waiters;
+
+    /// Wait statistics, in ticks, over threads that had to block.
+    unsigned long waits;
+    unsigned long totalWaitTicks;
+    unsigned long maxWaitTicks;
+};
+
+
+#endif
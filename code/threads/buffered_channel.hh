@@ -0,0 +1,263 @@
+/// Bounded buffered channels, a synchronization primitive
+///
+/// Unlike `Channel`, which makes every sender wait for a receiver, a
+/// `BufferedChannel` holds up to `capacity` messages of any type.  Senders
+/// only block when the buffer is full, and receivers only when it is empty,
+/// so a producer and a consumer can each run for a while without switching
+/// to the other on every message.
+///
+/// Messages are delivered in the order they were sent.  `SendMany` and
+/// `ReceiveMany` move several messages while taking the channel lock once,
+/// and the `Try` variants never block.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_BUFFEREDCHANNEL__HH
+#define NACHOS_THREADS_BUFFEREDCHANNEL__HH
+
+
+#include "condition.hh"
+
+
+template <class Item>
+class BufferedChannel {
+public:
+
+    /// Initialize an empty channel with room for `capacity` messages.
+    BufferedChannel(const char *debugName, unsigned capacity);
+
+    ~BufferedChannel();
+
+    const char *GetName() const;
+
+    unsigned GetCapacity() const;
+
+    /// Number of messages waiting to be received.
+    unsigned Count() const;
+
+    /// Send `item`, waiting while the channel is full.
+    void Send(const Item &item);
+
+    /// Receive the oldest message into `item`, waiting while the channel is
+    /// empty.
+    void Receive(Item *item);
+
+    /// Send `item` if there is room for it.  Return whether it was sent.
+    bool TrySend(const Item &item);
+
+    /// Receive the oldest message into `item` if there is one.  Return
+    /// whether a message was received.
+    bool TryReceive(Item *item);
+
+    /// Send the `count` messages in `items`, in order, waiting whenever the
+    /// channel is full.  Messages from other senders may be interleaved
+    /// while this one waits.
+    void SendMany(const Item *items, unsigned count);
+
+    /// Wait until there is at least one message, then receive up to `max`
+    /// of them into `items`.  Return how many were received.
+    unsigned ReceiveMany(Item *items, unsigned max);
+
+    /// Send as many of the `count` messages in `items` as fit without
+    /// waiting.  Return how many were sent.
+    unsigned TrySendMany(const Item *items, unsigned count);
+
+    /// Receive up to `max` messages into `items` without waiting.  Return
+    /// how many were received.
+    unsigned TryReceiveMany(Item *items, unsigned max);
+
+private:
+
+    const char *name;
+
+    /// Circular buffer of messages: `count` of them, the oldest at `head`.
+    Item *buffer;
+    unsigned capacity;
+    unsigned head;
+    unsigned count;
+
+    Lock *lock;
+    Condition *notFull;
+    Condition *notEmpty;
+
+    /// Move messages in or out of the buffer, as many as fit or are
+    /// available, up to `n`.  The lock must be held.  Return how many were
+    /// moved.
+    unsigned Put(const Item *items, unsigned n);
+    unsigned Take(Item *items, unsigned n);
+};
+
+template <class Item>
+BufferedChannel<Item>::BufferedChannel(const char *debugName,
+                                       unsigned capacity_)
+{
+    ASSERT(capacity_ > 0);
+
+    name     = debugName;
+    capacity = capacity_;
+    buffer   = new Item [capacity];
+    head     = 0;
+    count    = 0;
+    lock     = new Lock("buffered channel lock");
+    notFull  = new Condition("buffered channel not full", lock);
+    notEmpty = new Condition("buffered channel not empty", lock);
+}
+
+/// Assume no one is waiting on the channel.
+template <class Item>
+BufferedChannel<Item>::~BufferedChannel()
+{
+    delete notEmpty;
+    delete notFull;
+    delete lock;
+    delete [] buffer;
+}
+
+template <class Item>
+const char *
+BufferedChannel<Item>::GetName() const
+{
+    return name;
+}
+
+template <class Item>
+unsigned
+BufferedChannel<Item>::GetCapacity() const
+{
+    return capacity;
+}
+
+template <class Item>
+unsigned
+BufferedChannel<Item>::Count() const
+{
+    return count;
+}
+
+template <class Item>
+unsigned
+BufferedChannel<Item>::Put(const Item *items, unsigned n)
+{
+    unsigned moved = 0;
+    for (; moved < n && count < capacity; moved++) {
+        buffer[(head + count) % capacity] = items[moved];
+        count++;
+    }
+    if (moved == 1) {
+        notEmpty->Signal();
+    } else if (moved > 1) {
+        notEmpty->Broadcast();
+    }
+    return moved;
+}
+
+template <class Item>
+unsigned
+BufferedChannel<Item>::Take(Item *items, unsigned n)
+{
+    unsigned moved = 0;
+    for (; moved < n && count > 0; moved++) {
+        items[moved] = buffer[head];
+        head = (head + 1) % capacity;
+        count--;
+    }
+    if (moved == 1) {
+        notFull->Signal();
+    } else if (moved > 1) {
+        notFull->Broadcast();
+    }
+    return moved;
+}
+
+template <class Item>
+void
+BufferedChannel<Item>::Send(const Item &item)
+{
+    SendMany(&item, 1);
+}
+
+template <class Item>
+void
+BufferedChannel<Item>::Receive(Item *item)
+{
+    ASSERT(item != nullptr);
+    ReceiveMany(item, 1);
+}
+
+template <class Item>
+bool
+BufferedChannel<Item>::TrySend(const Item &item)
+{
+    return TrySendMany(&item, 1) == 1;
+}
+
+template <class Item>
+bool
+BufferedChannel<Item>::TryReceive(Item *item)
+{
+    ASSERT(item != nullptr);
+    return TryReceiveMany(item, 1) == 1;
+}
+
+template <class Item>
+void
+BufferedChannel<Item>::SendMany(const Item *items, unsigned n)
+{
+    ASSERT(items != nullptr || n == 0);
+
+    lock->Acquire();
+    unsigned sent = 0;
+    for (;;) {
+        sent += Put(&items[sent], n - sent);
+        if (sent == n) {
+            break;
+        }
+        notFull->Wait();
+    }
+    lock->Release();
+}
+
+template <class Item>
+unsigned
+BufferedChannel<Item>::ReceiveMany(Item *items, unsigned max)
+{
+    ASSERT(items != nullptr);
+    ASSERT(max > 0);
+
+    lock->Acquire();
+    while (count == 0) {
+        notEmpty->Wait();
+    }
+    unsigned received = Take(items, max);
+    lock->Release();
+    return received;
+}
+
+template <class Item>
+unsigned
+BufferedChannel<Item>::TrySendMany(const Item *items, unsigned n)
+{
+    ASSERT(items != nullptr || n == 0);
+
+    lock->Acquire();
+    unsigned sent = Put(items, n);
+    lock->Release();
+    return sent;
+}
+
+template <class Item>
+unsigned
+BufferedChannel<Item>::TryReceiveMany(Item *items, unsigned max)
+{
+    ASSERT(items != nullptr);
+
+    lock->Acquire();
+    unsigned received = Take(items, max);
+    lock->Release();
+    return received;
+}
+
+
+#endif
@@ -2,6 +2,7 @@
 #define NACHOS_THREADS_CHANNEL__HH
 
 #include "lock.hh"
+#include "semaphore.hh"
 
 class Channel {
 public:
@@ -17,64 +17,130 @@
 
 #include "condition.hh"
 #include "system.hh"
-#include <cstring>
-#include <iostream>
-/// Dummy functions -- so we can compile our later assignments.
-///
+#include "lib/slab.hh"
+
 
-Condition::Condition(const char *debugName, Lock *conditionLock)
+Condition::Condition(const char *debugName, Lock *conditionLock,
+                     WaitPolicy policy)
 {
-    char newname[100];
-    strcpy(newname, debugName);
-    strcat(newname, "sem");
-    lock = conditionLock;
+    ASSERT(conditionLock != nullptr);
+
     name = debugName;
-    lock_waits = new Lock("lockWaits");
-    sem = new Semaphore(newname, 0);
+    lock = conditionLock;
+    waiters = new WaitQueue(policy);
     DEBUG('s', "Condition variable %s created by %p\n", name, currentThread);
 }
 
+/// Assume no one is waiting on the condition.
 Condition::~Condition()
 {
-    delete lock_waits;
-    delete sem;
+    delete waiters;
     DEBUG('s', "Condition variable %s destroyed by %p\n", name, currentThread);
 }
 
+/// Cache for `Condition` objects, built on first use.
+static SlabCache &
+ConditionCache()
+{
+    static SlabCache cache("Condition", sizeof (Condition));
+    return cache;
+}
+
+void *
+Condition::operator new(size_t size)
+{
+    ASSERT(size == sizeof (Condition));
+    return ConditionCache().Alloc();
+}
+
+void
+Condition::operator delete(void *p)
+{
+    ConditionCache().Free(p);
+}
+
 const char *
 Condition::GetName() const
 {
     return name;
 }
 
+/// Releasing the lock and going to sleep must be atomic, or a `Signal`
+/// between the two would be lost.
 void
 Condition::Wait()
 {
     ASSERT(lock->IsHeldByCurrentThread());
-    lock_waits->Acquire();
-    waits++;
-    lock_waits->Release();
 
-    DEBUG('s', "Thread %p waiting condicion variable %s\n", currentThread, name);
-    
-    DEBUG('s', "Release condition 56\n");
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    DEBUG('s', "Thread %p waiting condition variable %s\n",
+          currentThread, name);
+    unsigned long waitStart = stats->totalTicks;
+    waiters->Append(currentThread);
+    lock->Release();
+    currentThread->Sleep();
+
+    interrupt->SetLevel(oldLevel);
+
+    Reacquire(waitStart);
+}
+
+bool
+Condition::TimedWait(unsigned long ticks)
+{
+    ASSERT(lock->IsHeldByCurrentThread());
+
+    if (ticks == 0) {
+        return false;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    DEBUG('s', "Thread %p waiting condition variable %s for %lu ticks\n",
+          currentThread, name, ticks);
+    unsigned long waitStart = stats->totalTicks;
+    Sleeper sleeper = {
+        currentThread, waitStart + ticks, waiters, false
+    };
+    waiters->Append(currentThread);
+    sleepQueue->Add(&sleeper);
     lock->Release();
+    currentThread->Sleep();
+    sleepQueue->Remove(&sleeper);
 
-    sem->P();
+    interrupt->SetLevel(oldLevel);
 
-    lock->Acquire();
+    Reacquire(waitStart);
+    return !sleeper.expired;
+}
+
+/// A thread moved to the lock by `Broadcast` was handed it by
+/// `Lock::Release`; one woken up by `Signal`, or whose time ran out, was
+/// just made ready, and must compete for the lock.
+void
+Condition::Reacquire(unsigned long waitStart)
+{
+    if (lock->IsHeldByCurrentThread()) {
+        lock->FinishAddedWaiter(waitStart);
+    } else {
+        lock->Acquire();
+    }
 }
 
 void
 Condition::Signal()
 {
     ASSERT(lock->IsHeldByCurrentThread());
-    lock_waits->Acquire();
-    if (waits > 0) {
-        sem->V();
-        waits--;
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    Thread *thread = waiters->Pop();
+    if (thread != nullptr) {
+        scheduler->ReadyToRun(thread);
     }
-    lock_waits->Release();
+
+    interrupt->SetLevel(oldLevel);
     DEBUG('s', "Condition variable %s signaled by %p\n", name, currentThread);
 }
 
@@ -82,11 +148,17 @@ void
 Condition::Broadcast()
 {
     ASSERT(lock->IsHeldByCurrentThread());
-    lock_waits->Acquire();
-    while (waits > 0) {
-        sem->V();
-        waits--;
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    // Waiters leave in the order of the policy, and then get the lock in
+    // the order of the lock's own.
+    Thread *thread;
+    while ((thread = waiters->Pop()) != nullptr) {
+        lock->AddWaiter(thread);
     }
-    lock_waits->Release();
-    DEBUG('s', "Condition variable %s broadcasted by %p\n", name, currentThread);
+
+    interrupt->SetLevel(oldLevel);
+    DEBUG('s', "Condition variable %s broadcasted by %p\n",
+          name, currentThread);
 }
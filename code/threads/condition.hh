@@ -19,6 +19,7 @@
 
 
 #include "lock.hh"
+#include "wait_queue.hh"
 
 
 /// This class defines a “condition variable”.
@@ -53,14 +54,32 @@
 /// The “Mesa” style is somewhat simpler to implement, but it does not
 /// guarantee that the woken thread recover the control of the lock
 /// immediately.
+///
+/// Waiters are kept in a `WaitQueue`, whose policy decides which of them
+/// `Signal` awakens: the one of highest effective priority by default, or
+/// the one that has waited longest.
+///
+/// `Broadcast` does not make waiters ready: since the broadcasting thread
+/// holds the lock, most of them would only run to block on it again.
+/// Instead they are moved to the lock's own queue, and `Lock::Release`
+/// wakes them up one at a time, already holding it.  `Signal` still makes
+/// its waiter ready, so that the signaling thread can take the lock again
+/// before it runs.
 class Condition {
 public:
 
     /// Constructor: indicate which lock the condition variable belongs to.
-    Condition(const char *debugName, Lock *conditionLock);
+    ///
+    /// `policy` decides which waiter `Signal` wakes up.
+    Condition(const char *debugName, Lock *conditionLock,
+              WaitPolicy policy = WAIT_PRIORITY);
 
     ~Condition();
 
+    /// Condition variables come from a slab cache.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     const char *GetName() const;
 
     /// The three operations on condition variables.
@@ -72,14 +91,25 @@ public:
     void Signal();
     void Broadcast();
 
+    /// Like `Wait`, but stop waiting after `ticks` ticks.  The lock is held
+    /// again on return either way.
+    ///
+    /// Return `false` if the time ran out before a `Signal` or `Broadcast`.
+    bool TimedWait(unsigned long ticks);
+
 private:
 
     const char *name;
-    Lock* lock;
-    int waits = 0;
-    Lock* lock_waits;
-    Semaphore* sem;
-    // Other needed fields are to be added here.
+
+    /// Lock protecting the condition.
+    Lock *lock;
+
+    /// Threads blocked in `Wait`.
+    WaitQueue *waiters;
+
+    /// Get the lock back after waking up in `Wait` or `TimedWait`, where
+    /// waiting started at `waitStart`.
+    void Reacquire(unsigned long waitStart);
 };
 
 
@@ -0,0 +1,103 @@
+/// Routines for count-down latches.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "count_down_latch.hh"
+#include "system.hh"
+
+#include <stdio.h>
+
+
+CountDownLatch::CountDownLatch(const char *debugName, unsigned count_)
+{
+    name    = debugName;
+    count   = count_;
+    generation = 0;
+    waiters = new WaitQueue;
+    waits = totalWaitTicks = maxWaitTicks = 0;
+    DEBUG('s', "Latch %s created by %p\n", name, currentThread);
+}
+
+CountDownLatch::~CountDownLatch()
+{
+    ASSERT(waiters->IsEmpty());
+
+    DEBUG('s', "Latch %s: %lu waits, %lu ticks waited (max %lu)\n",
+          name, waits, totalWaitTicks, maxWaitTicks);
+    delete waiters;
+}
+
+const char *
+CountDownLatch::GetName() const
+{
+    return name;
+}
+
+unsigned
+CountDownLatch::GetCount() const
+{
+    return count;
+}
+
+void
+CountDownLatch::CountDown()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (count > 0 && --count == 0) {
+        generation++;
+        Thread *thread;
+        while ((thread = waiters->Pop()) != nullptr) {
+            scheduler->ReadyToRun(thread);
+        }
+        DEBUG('s', "Latch %s open\n", name);
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+CountDownLatch::Wait()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (count > 0) {
+        unsigned long start = stats->totalTicks;
+        unsigned myGeneration = generation;
+        while (generation == myGeneration) {
+            waiters->Append(currentThread);
+            currentThread->Sleep();
+        }
+
+        unsigned long waited = stats->totalTicks - start;
+        waits++;
+        totalWaitTicks += waited;
+        if (waited > maxWaitTicks) {
+            maxWaitTicks = waited;
+        }
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+CountDownLatch::Reset(unsigned count_)
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    ASSERT(count == 0);
+    count = count_;
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+CountDownLatch::Print() const
+{
+    printf("Latch %s: count %u\n", name, count);
+    printf("    waits: %lu, ticks waited: %lu total, %lu max\n",
+           waits, totalWaitTicks, maxWaitTicks);
+}
@@ -0,0 +1,70 @@
+/// Count-down latches, a synchronization primitive
+///
+/// A latch starts with a count.  Threads calling `CountDown` decrement it,
+/// and threads calling `Wait` block until it reaches zero, at which point
+/// all of them go on at once.  Once open, the latch stays open, so later
+/// calls to `Wait` return immediately.
+///
+/// Typical use: a thread starts N workers, each of which calls `CountDown`
+/// when done, and then waits on a latch of count N.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_COUNTDOWNLATCH__HH
+#define NACHOS_THREADS_COUNTDOWNLATCH__HH
+
+
+#include "wait_queue.hh"
+
+
+class CountDownLatch {
+public:
+
+    /// Constructor: set up a latch that opens after `count` calls to
+    /// `CountDown`.
+    CountDownLatch(const char *debugName, unsigned count);
+
+    /// Assume no one is waiting on the latch.
+    ~CountDownLatch();
+
+    /// For debugging.
+    const char *GetName() const;
+
+    unsigned GetCount() const;
+
+    /// Decrement the count, waking up every waiter if it reaches zero.
+    /// Does nothing if the latch is already open.
+    void CountDown();
+
+    /// Wait until the count reaches zero.
+    void Wait();
+
+    /// Close an open latch again, with a new `count`.
+    void Reset(unsigned count);
+
+    /// Print wait statistics.
+    void Print() const;
+
+private:
+
+    /// For debugging.
+    const char *name;
+
+    unsigned count;
+
+    /// Number of times the latch has opened.  Waiters look at it rather
+    /// than at `count`, which `Reset` may raise before they get to run.
+    unsigned generation;
+
+    WaitQueue *waiters;
+
+    /// Wait statistics, in ticks, over threads that had to block.
+    unsigned long waits;
+    unsigned long totalWaitTicks;
+    unsigned long maxWaitTicks;
+};
+
+
+#endif
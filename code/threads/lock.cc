@@ -15,68 +15,117 @@
 /// limitation of liability and disclaimer of warranty provisions.
 #include "lock.hh"
 #include "system.hh"
+#include "lib/slab.hh"
 #include "scheduler.hh"
 #include <stdio.h>
 
-/// Dummy functions -- so we can compile our later assignments.
 
-Lock::Lock(const char *debugName)
+Lock::Lock(const char *debugName, WaitPolicy policy)
 {
-    sem = new Semaphore(debugName, 1);
     name = debugName;
-    lockOwner = NULL;
+    lockOwner = nullptr;
+    waiters = new WaitQueue(policy);
+    profile = lockProfiler != nullptr ? lockProfiler->Register(name)
+                                      : nullptr;
+    depClass = lockDep != nullptr ? lockDep->Register(name) : -1;
     DEBUG('s', "Lock %s created by %p\n", name, currentThread);
 }
 
+/// Assume no one holds the lock nor is waiting for it.
 Lock::~Lock()
 {
-    sem->~Semaphore();
-    lockOwner = NULL;
+    delete waiters;
     DEBUG('s', "Lock %s destroyed by %p\n", name, currentThread);
 }
 
+/// Cache for `Lock` objects, built on first use.
+static SlabCache &
+LockCache()
+{
+    static SlabCache cache("Lock", sizeof (Lock));
+    return cache;
+}
+
+void *
+Lock::operator new(size_t size)
+{
+    ASSERT(size == sizeof (Lock));
+    return LockCache().Alloc();
+}
+
+void
+Lock::operator delete(void *p)
+{
+    LockCache().Free(p);
+}
+
 const char *
 Lock::GetName() const
 {
     return name;
 }
 
-unsigned Lock::getMaxPriority()
+unsigned
+Lock::GetMaxWaiterPriority() const
 {
-    int i; 
-    for(i = MAX_PRIORITY; i > 0; i--){
-        if(priorities[i]) break;
-    }
-    return i;
+    return waiters->GetMaxPriority();
 }
 
-/*
-    El problema no se podría resolver con semáforos ya que con los mismos
-    cualquier hilo puede liberar el semáforo. En cambio con los locks, al 
-    solo el dueño poder levantarlo, se puede solucionar el problema.
+/// Donate `priority` along the chain of lock holders.
+///
+/// If A blocks on a lock held by B, and B is blocked on a lock held by C,
+/// then both B and C must run at least at A's priority, or A would be
+/// stalled behind C's low priority.
+///
+/// The walk stops as soon as a holder already runs at `priority` or above,
+/// which also guarantees that it ends even if the chain is a deadlock
+/// cycle.
+void
+Lock::Donate(unsigned priority)
+{
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+
+    Thread *holder = lockOwner;
+    while (holder != nullptr && holder->GetPriority() < priority) {
+        DEBUG('s', "Thread %s donates priority %u to %s\n",
+              currentThread->GetName(), priority, holder->GetName());
+        scheduler->ChangePriority(holder, priority);
 
-*/
+        Lock *next = holder->GetWaitingLock();
+        holder = next != nullptr ? next->lockOwner : nullptr;
+    }
+}
 
 void
 Lock::Acquire()
-{      
+{
     ASSERT(!IsHeldByCurrentThread());
-    /// Me fijo si tengo una prioridad mas alta que la actual del lock y si la tengo cambio la del lock y la del lock owner
-    unsigned priority = currentThread->GetOriginalPriority();
-
-    if(lockOwner != nullptr &&lockOwner->GetPriority() < priority)
-        scheduler->ChangePriority(lockOwner, priority);
-
-    
-    priorities[priority]++;
 
-    sem->P();
+    if (lockDep != nullptr) {
+        lockDep->Acquire(depClass, __builtin_return_address(0));
+    }
 
-    /// Me fijo si el lock tiene una prioridad mas alta que yo si la tiene cambio mi prioridad para tenerla
-    if(getMaxPriority() > priority)
-        scheduler->ChangePriority(currentThread, getMaxPriority());
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    bool contended = lockOwner != nullptr;
+    unsigned long waitStart = stats->totalTicks;
+    if (!contended) {
+        lockOwner = currentThread;
+        currentThread->AddHeldLock(this);
+    } else {
+        currentThread->SetWaitingLock(this);
+        waiters->Append(currentThread);
+        Donate(currentThread->GetPriority());
+        currentThread->Sleep();
+        // `Release` handed us the lock.
+    }
+    ASSERT(lockOwner == currentThread);
+    if (profile != nullptr) {
+        profile->Acquired(currentThread->GetName(), contended,
+                          stats->totalTicks - waitStart);
+    }
 
-    lockOwner = currentThread;
+    interrupt->SetLevel(oldLevel);
     DEBUG('s', "Lock %s acquired by %p\n", name, currentThread);
 }
 
@@ -86,18 +135,62 @@ Lock::Release()
     DEBUG('s', "Lock %s try to be released by %p, lockowner %p\n", name, currentThread, lockOwner);
     ASSERT(IsHeldByCurrentThread());
 
-    lockOwner = NULL;
-    
-    priorities[currentThread->GetOriginalPriority()] --;
-    
-    sem->V();
-    
-    /// Vuelvo mi prioridad a la original
-    currentThread->SetPriority(currentThread->GetOriginalPriority());
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
 
+    if (profile != nullptr) {
+        profile->Released();
+    }
+    if (lockDep != nullptr) {
+        lockDep->Release(depClass);
+    }
+    currentThread->RemoveHeldLock(this);
+
+    Thread *next = waiters->Pop();
+    lockOwner = next;
+    if (next != nullptr) {
+        next->SetWaitingLock(nullptr);
+        next->AddHeldLock(this);
+        next->RecomputePriority();  // Inherit from the remaining waiters.
+        scheduler->ReadyToRun(next);
+    }
+
+    // Drop whatever was donated through this lock.
+    currentThread->RecomputePriority();
+
+    interrupt->SetLevel(oldLevel);
     DEBUG('s', "Lock %s released by %p\n", name, currentThread);
 }
 
+void
+Lock::AddWaiter(Thread *thread)
+{
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+    ASSERT(thread != nullptr && thread != lockOwner);
+    ASSERT(lockOwner != nullptr);
+
+    DEBUG('s', "Thread %p moved to the waiters of lock %s\n", thread, name);
+    thread->SetWaitingLock(this);
+    waiters->Append(thread);
+    Donate(thread->GetPriority());
+}
+
+void
+Lock::FinishAddedWaiter(unsigned long waitStart)
+{
+    ASSERT(IsHeldByCurrentThread());
+
+    if (lockDep != nullptr) {
+        lockDep->Acquire(depClass, __builtin_return_address(0));
+    }
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+    if (profile != nullptr) {
+        profile->Acquired(currentThread->GetName(), true,
+                          stats->totalTicks - waitStart);
+    }
+    interrupt->SetLevel(oldLevel);
+    DEBUG('s', "Lock %s acquired by %p\n", name, currentThread);
+}
+
 bool
 Lock::IsHeldByCurrentThread() const
 {
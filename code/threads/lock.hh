@@ -17,7 +17,8 @@
 #ifndef NACHOS_THREADS_LOCK__HH
 #define NACHOS_THREADS_LOCK__HH
 
-#include "semaphore.hh"
+#include "wait_queue.hh"
+#include "lock_profile.hh"
 
 /// This class defines a “lock”.
 ///
@@ -30,14 +31,30 @@
 ///
 /// For convenience, nobody but the thread that holds the lock can free it.
 /// There is no operation for reading the state of the lock.
+///
+/// Locks implement priority inheritance: a thread that blocks on a lock
+/// donates its priority to the holder, and further down the chain if the
+/// holder is itself blocked on another lock.  A thread runs at the highest
+/// priority among its own and those of the waiters of every lock it holds;
+/// it is recomputed whenever it releases a lock.
+///
+/// `Release` hands the lock directly to a waiter, which wakes up already
+/// holding it.  Condition variables rely on this to move their waiters
+/// straight to the lock (see `Condition::Broadcast`).
 class Lock {
 public:
 
     /// Constructor: set up the lock as free.
-    Lock(const char *debugName);
+    ///
+    /// `policy` decides which waiter gets the lock when it is released.
+    Lock(const char *debugName, WaitPolicy policy = WAIT_PRIORITY);
 
     ~Lock();
 
+    /// Locks come from a slab cache.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     /// For debugging.
     const char *GetName() const;
 
@@ -47,22 +64,48 @@ public:
     void Acquire();
     void Release();
 
-    unsigned getMaxPriority();
+    /// Highest priority among the threads waiting for the lock, or zero if
+    /// there are none.
+    unsigned GetMaxWaiterPriority() const;
+
     /// Returns `true` if the current thread is the one that possesses the
     /// lock.
     ///
     /// Useful for checks in `Release` and in condition variables.
     bool IsHeldByCurrentThread() const;
 
+    /// Make `thread`, which is blocked but not on this lock, wait for the
+    /// lock as if it had called `Acquire`.  The lock must be held.
+    ///
+    /// `thread` wakes up holding the lock, and must then call
+    /// `FinishAddedWaiter`.  Assumes that interrupts are disabled.
+    void AddWaiter(Thread *thread);
+
+    /// Account for an acquisition started by `AddWaiter`, once the current
+    /// thread holds the lock; `waitStart` is when it began to wait.
+    void FinishAddedWaiter(unsigned long waitStart);
+
 private:
 
     /// For debugging.
-    Semaphore* sem;
     const char *name;
-    Thread* lockOwner;
 
-    unsigned priorities[MAX_PRIORITY + 1];
-    // Add other needed fields here.
+    /// Thread holding the lock, null if the lock is free.
+    Thread *lockOwner;
+
+    /// Threads blocked in `Acquire`.
+    WaitQueue *waiters;
+
+    /// Contention statistics, null unless profiling is enabled.  Owned by
+    /// `lockProfiler`.
+    LockProfile *profile;
+
+    /// Class of the lock for `lockDep`, -1 if not validated.
+    int depClass;
+
+    /// Raise the priority of the holder of the lock to at least `priority`,
+    /// following the chain of locks the holders are blocked on.
+    void Donate(unsigned priority);
 };
 
 #endif
@@ -0,0 +1,204 @@
+/// Routines for the lock dependency validator.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "lock_dep.hh"
+#include "system.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+
+static char *
+CopyName(const char *name)
+{
+    char *copy = new char [strlen(name) + 1];
+    strcpy(copy, name);
+    return copy;
+}
+
+LockDep::LockDep()
+{
+    numClasses = 0;
+    numEdges   = 0;
+    numCycles  = 0;
+    memset(edges, 0, sizeof edges);
+}
+
+LockDep::~LockDep()
+{
+    for (unsigned i = 0; i < numClasses; i++) {
+        for (unsigned j = 0; j < numClasses; j++) {
+            if (edges[i][j] != nullptr) {
+                delete [] edges[i][j]->threadName;
+                delete edges[i][j];
+            }
+        }
+        delete [] names[i];
+    }
+}
+
+int
+LockDep::Register(const char *lockName)
+{
+    ASSERT(lockName != nullptr);
+
+    for (unsigned i = 0; i < numClasses; i++) {
+        if (strcmp(names[i], lockName) == 0) {
+            return i;
+        }
+    }
+    if (numClasses == MAX_LOCK_CLASSES) {
+        DEBUG('s', "Lockdep: no room for lock class %s\n", lockName);
+        return -1;
+    }
+    names[numClasses] = CopyName(lockName);
+    return numClasses++;
+}
+
+void
+LockDep::Acquire(int lockClass, void *site)
+{
+    if (lockClass == -1) {
+        return;
+    }
+    ASSERT(lockClass >= 0 && (unsigned) lockClass < numClasses);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    HeldLockClasses *held = &currentThread->heldLockClasses;
+    for (unsigned i = 0; i < held->count; i++) {
+        int from = held->classes[i];
+        if (edges[from][lockClass] == nullptr) {
+            AddEdge(from, lockClass, held->sites[i], site);
+        }
+    }
+    if (held->count < HeldLockClasses::MAX_DEPTH) {
+        held->classes[held->count] = lockClass;
+        held->sites[held->count]   = site;
+        held->count++;
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+LockDep::Release(int lockClass)
+{
+    if (lockClass == -1) {
+        return;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    // Locks need not be released in the reverse order they were taken in,
+    // so look for the innermost lock of the class.
+    HeldLockClasses *held = &currentThread->heldLockClasses;
+    for (unsigned i = held->count; i > 0; i--) {
+        if (held->classes[i - 1] == lockClass) {
+            for (unsigned j = i; j < held->count; j++) {
+                held->classes[j - 1] = held->classes[j];
+                held->sites[j - 1]   = held->sites[j];
+            }
+            held->count--;
+            break;
+        }
+    }
+
+    interrupt->SetLevel(oldLevel);
+}
+
+void
+LockDep::AddEdge(int from, int to, void *fromSite, void *toSite)
+{
+    EdgeInfo *edge = new EdgeInfo;
+    edge->from       = from;
+    edge->to         = to;
+    edge->threadName = CopyName(currentThread->GetName());
+    edge->fromSite   = fromSite;
+    edge->toSite     = toSite;
+
+    // Look for the cycle before adding the edge, so that the search does
+    // not find the edge itself.
+    CheckCycle(edge);
+    edges[from][to] = edge;
+    numEdges++;
+}
+
+void
+LockDep::PrintEdge(const char *fromName, const char *toName,
+                   const EdgeInfo *edge)
+{
+    printf("    thread \"%s\" acquires \"%s\" at %p\n"
+           "        while holding \"%s\", acquired at %p\n",
+           edge->threadName, toName, edge->toSite, fromName, edge->fromSite);
+}
+
+void
+LockDep::CheckCycle(const EdgeInfo *edge)
+{
+    int from = edge->from, to = edge->to;
+
+    // Breadth-first search from `to`, remembering how each class was
+    // reached.
+    int parent[MAX_LOCK_CLASSES];
+    int queue[MAX_LOCK_CLASSES];
+    for (unsigned i = 0; i < numClasses; i++) {
+        parent[i] = -1;
+    }
+    unsigned head = 0, tail = 0;
+    queue[tail++] = to;
+    parent[to] = to;
+    while (head < tail && parent[from] == -1) {
+        int u = queue[head++];
+        for (unsigned v = 0; v < numClasses; v++) {
+            if (edges[u][v] != nullptr && parent[v] == -1) {
+                parent[v] = u;
+                queue[tail++] = v;
+            }
+        }
+    }
+    if (parent[from] == -1) {
+        return;
+    }
+
+    numCycles++;
+    printf("*** Lockdep: possible deadlock\n");
+    PrintEdge(names[from], names[to], edge);
+    if (from == to) {
+        printf("    which is already held, through another lock of the same "
+               "class\n");
+        return;
+    }
+    printf("    but the opposite order is already known:\n");
+
+    // Walking back from `from` lists the path reversed; keep it in an
+    // array to print it forwards.
+    int path[MAX_LOCK_CLASSES];
+    unsigned length = 0;
+    for (int c = from; c != to; c = parent[c]) {
+        path[length++] = c;
+    }
+    path[length++] = to;
+    for (unsigned i = length - 1; i > 0; i--) {
+        const EdgeInfo *step = edges[path[i]][path[i - 1]];
+        ASSERT(step != nullptr);
+        PrintEdge(names[step->from], names[step->to], step);
+    }
+}
+
+unsigned
+LockDep::GetNumCycles() const
+{
+    return numCycles;
+}
+
+void
+LockDep::Print() const
+{
+    printf("Lockdep: %u lock classes, %u dependencies, "
+           "%u possible deadlocks\n", numClasses, numEdges, numCycles);
+}
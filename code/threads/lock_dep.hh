@@ -0,0 +1,104 @@
+/// Lock dependency validator.
+///
+/// When enabled with the `lockdep` debug option (`-do lockdep`), every
+/// acquisition of a `Lock` or `RWLock` is checked against the order in
+/// which locks have been taken so far, and a possible deadlock is reported
+/// as soon as two threads could each wait for a lock the other holds,
+/// even if the run happens not to hang.
+///
+/// Locks are grouped in classes by name: all the locks created with the
+/// same name (for instance, the lock of every open file) are one class.
+/// The validator keeps a graph with an edge from class A to class B the
+/// first time some thread acquires a B lock while holding an A lock.  An
+/// edge that closes a cycle in the graph is a possible deadlock; the cycle
+/// is printed with the thread that first took each edge, and the
+/// acquisition sites (return addresses into the callers of `Acquire`;
+/// `info symbol` in `gdb` turns them into function names).
+///
+/// Checking an acquisition that follows known edges costs a handful of
+/// lookups in a table; the graph is only searched when a new edge appears,
+/// which stops happening soon in a long run.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_LOCKDEP__HH
+#define NACHOS_THREADS_LOCKDEP__HH
+
+
+/// Maximum number of lock classes tracked; locks of further classes are
+/// not validated.
+const unsigned MAX_LOCK_CLASSES = 128;
+
+/// Lock classes held by a thread, innermost last.  Deeper nesting is not
+/// validated.
+struct HeldLockClasses {
+    static const unsigned MAX_DEPTH = 16;
+
+    int classes[MAX_DEPTH];
+    void *sites[MAX_DEPTH];
+    unsigned count;
+
+    HeldLockClasses()
+    {
+        count = 0;
+    }
+};
+
+class LockDep {
+public:
+
+    LockDep();
+
+    ~LockDep();
+
+    /// Return the class of locks called `lockName`, or -1 if there is no
+    /// room for a new class.
+    int Register(const char *lockName);
+
+    /// The current thread is about to acquire a lock of class `lockClass`,
+    /// and may block; `site` is where `Acquire` was called from.
+    ///
+    /// Record the new dependencies, and report any cycle they close.
+    void Acquire(int lockClass, void *site);
+
+    /// The current thread released a lock of class `lockClass`.
+    void Release(int lockClass);
+
+    /// Number of possible deadlocks reported so far.
+    unsigned GetNumCycles() const;
+
+    /// Print a summary of the graph.
+    void Print() const;
+
+private:
+
+    /// Class names.
+    char *names[MAX_LOCK_CLASSES];
+    unsigned numClasses;
+
+    /// Where an edge was first seen.
+    struct EdgeInfo {
+        int from, to;
+        char *threadName;
+        void *fromSite, *toSite;
+    };
+
+    /// Edge from the first class to the second, null if none.
+    EdgeInfo *edges[MAX_LOCK_CLASSES][MAX_LOCK_CLASSES];
+    unsigned numEdges;
+
+    unsigned numCycles;
+
+    void AddEdge(int from, int to, void *fromSite, void *toSite);
+
+    /// If the new `edge` closes a cycle in the graph, report it.
+    void CheckCycle(const EdgeInfo *edge);
+
+    static void PrintEdge(const char *fromName, const char *toName,
+                          const EdgeInfo *edge);
+};
+
+
+#endif
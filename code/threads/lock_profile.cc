@@ -0,0 +1,214 @@
+/// Routines for lock contention profiling.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "lock_profile.hh"
+#include "system.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+
+/// Number of waiters shown per lock in the report.
+static const unsigned REPORT_WAITERS = 3;
+
+LockProfile::LockProfile(const char *lockName)
+{
+    ASSERT(lockName != nullptr);
+
+    name = new char [strlen(lockName) + 1];
+    strcpy(name, lockName);
+    acquisitions = contended = 0;
+    totalWaitTicks = maxWaitTicks = maxHoldTicks = 0;
+    heldSince = 0;
+    numWaiters = 0;
+    otherWaits = otherWaitTicks = 0;
+}
+
+LockProfile::~LockProfile()
+{
+    delete [] name;
+}
+
+const char *
+LockProfile::GetName() const
+{
+    return name;
+}
+
+void
+LockProfile::Acquired(const char *threadName, bool wasContended,
+                      unsigned long waitTicks)
+{
+    ASSERT(threadName != nullptr);
+
+    acquisitions++;
+    heldSince = stats->totalTicks;
+    if (!wasContended) {
+        return;
+    }
+
+    contended++;
+    totalWaitTicks += waitTicks;
+    if (waitTicks > maxWaitTicks) {
+        maxWaitTicks = waitTicks;
+    }
+
+    unsigned i = 0;
+    while (i < numWaiters
+             && strncmp(waiters[i].name, threadName, WAITER_NAME_LEN - 1)) {
+        i++;
+    }
+    if (i == numWaiters) {
+        if (numWaiters == MAX_WAITERS) {
+            otherWaits++;
+            otherWaitTicks += waitTicks;
+            return;
+        }
+        snprintf(waiters[i].name, WAITER_NAME_LEN, "%s", threadName);
+        waiters[i].waits = waiters[i].waitTicks = 0;
+        numWaiters++;
+    }
+    waiters[i].waits++;
+    waiters[i].waitTicks += waitTicks;
+}
+
+void
+LockProfile::Released()
+{
+    unsigned long held = stats->totalTicks - heldSince;
+    if (held > maxHoldTicks) {
+        maxHoldTicks = held;
+    }
+}
+
+unsigned long
+LockProfile::GetContended() const
+{
+    return contended;
+}
+
+unsigned long
+LockProfile::GetTotalWaitTicks() const
+{
+    return totalWaitTicks;
+}
+
+void
+LockProfile::Print(unsigned maxWaiters) const
+{
+    printf("  %-24s acquired %lu, contended %lu", name, acquisitions,
+           contended);
+    if (acquisitions > 0) {
+        printf(" (%lu%%)", contended * 100 / acquisitions);
+    }
+    printf(", wait %lu (max %lu), max hold %lu\n",
+           totalWaitTicks, maxWaitTicks, maxHoldTicks);
+
+    // Selection of the longest waiters; there are only a handful.
+    bool shown[MAX_WAITERS] = {};
+    for (unsigned n = 0; n < maxWaiters && n < numWaiters; n++) {
+        unsigned best = 0;
+        bool found = false;
+        for (unsigned i = 0; i < numWaiters; i++) {
+            if (!shown[i] && (!found
+                              || waiters[i].waitTicks
+                                   > waiters[best].waitTicks)) {
+                best  = i;
+                found = true;
+            }
+        }
+        shown[best] = true;
+        printf("      %-20s waited %lu times, %lu ticks\n",
+               waiters[best].name, waiters[best].waits,
+               waiters[best].waitTicks);
+    }
+    if (otherWaits > 0) {
+        printf("      %-20s waited %lu times, %lu ticks\n",
+               "(others)", otherWaits, otherWaitTicks);
+    }
+}
+
+LockProfiler::LockProfiler()
+{
+    profiles    = new List<LockProfile *>;
+    numProfiles = 0;
+}
+
+static void
+DeleteProfile(LockProfile *profile)
+{
+    delete profile;
+}
+
+LockProfiler::~LockProfiler()
+{
+    profiles->Apply(DeleteProfile);
+    delete profiles;
+}
+
+LockProfile *
+LockProfiler::Register(const char *lockName)
+{
+    LockProfile *profile = new LockProfile(lockName);
+    profiles->Append(profile);
+    numProfiles++;
+    return profile;
+}
+
+/// Profiles gathered into an array, to be sorted.
+struct Collection {
+    LockProfile **profiles;
+    unsigned count;
+};
+
+static void
+CollectProfile(LockProfile *profile, void *collection_)
+{
+    Collection *collection = (Collection *) collection_;
+    collection->profiles[collection->count++] = profile;
+}
+
+void
+LockProfiler::Print() const
+{
+    if (numProfiles == 0) {
+        printf("Lock profile: no locks\n");
+        return;
+    }
+
+    Collection collection = { new LockProfile *[numProfiles], 0 };
+    profiles->Apply(CollectProfile, &collection);
+    ASSERT(collection.count == numProfiles);
+    LockProfile **collected = collection.profiles;
+    unsigned numCollected = collection.count;
+
+    // Insertion sort by decreasing wait time, stable so that locks with
+    // equal waits stay in creation order.
+    for (unsigned i = 1; i < numCollected; i++) {
+        LockProfile *p = collected[i];
+        unsigned j = i;
+        for (; j > 0 && collected[j - 1]->GetTotalWaitTicks()
+                          < p->GetTotalWaitTicks(); j--) {
+            collected[j] = collected[j - 1];
+        }
+        collected[j] = p;
+    }
+
+    printf("Lock profile (%u locks, by total wait in ticks):\n",
+           numProfiles);
+    unsigned uncontended = 0;
+    for (unsigned i = 0; i < numCollected; i++) {
+        if (collected[i]->GetContended() == 0) {
+            uncontended++;
+        } else {
+            collected[i]->Print(REPORT_WAITERS);
+        }
+    }
+    printf("  %u locks never contended\n", uncontended);
+
+    delete [] collected;
+}
@@ -0,0 +1,100 @@
+/// Lock contention profiling.
+///
+/// When enabled with the `profile` debug option (`-do profile`), every
+/// `Lock` gets a `LockProfile` that counts acquisitions, how many of them
+/// had to wait, how long the waits and the holds took, and which threads
+/// waited the most.  The profiles outlive their locks, so that locks
+/// created and destroyed on the fly (like those of open files) are still
+/// reported.  The report is printed when the machine halts, hottest locks
+/// first.
+///
+/// Times are measured in simulated ticks.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_LOCKPROFILE__HH
+#define NACHOS_THREADS_LOCKPROFILE__HH
+
+
+#include "lib/list.hh"
+
+
+/// Statistics of a single lock.
+class LockProfile {
+public:
+
+    LockProfile(const char *lockName);
+
+    ~LockProfile();
+
+    const char *GetName() const;
+
+    /// The lock was acquired by `threadName`, after waiting `waitTicks`
+    /// for it if `wasContended`.
+    void Acquired(const char *threadName, bool wasContended,
+                  unsigned long waitTicks);
+
+    /// The lock was released by its holder.
+    void Released();
+
+    unsigned long GetContended() const;
+
+    unsigned long GetTotalWaitTicks() const;
+
+    /// Print the statistics, with up to `maxWaiters` of the threads that
+    /// waited the longest.
+    void Print(unsigned maxWaiters) const;
+
+private:
+
+    /// Copy of the name of the lock, which may be gone by report time.
+    char *name;
+
+    unsigned long acquisitions;
+    unsigned long contended;
+    unsigned long totalWaitTicks;
+    unsigned long maxWaitTicks;
+    unsigned long maxHoldTicks;
+
+    /// When the current holder got the lock.
+    unsigned long heldSince;
+
+    /// Waiting time per thread name.  Threads beyond `MAX_WAITERS` distinct
+    /// names are lumped together.
+    static const unsigned MAX_WAITERS = 16;
+    static const unsigned WAITER_NAME_LEN = 24;
+    struct Waiter {
+        char name[WAITER_NAME_LEN];
+        unsigned long waits;
+        unsigned long waitTicks;
+    };
+    Waiter waiters[MAX_WAITERS];
+    unsigned numWaiters;
+    unsigned long otherWaits, otherWaitTicks;
+};
+
+/// Keeps the profile of every lock created while profiling is enabled.
+class LockProfiler {
+public:
+
+    LockProfiler();
+
+    ~LockProfiler();
+
+    /// Create the profile for a new lock called `lockName`.
+    LockProfile *Register(const char *lockName);
+
+    /// Print the profile of every lock that was ever contended, sorted by
+    /// decreasing total wait time.  Other locks are only counted.
+    void Print() const;
+
+private:
+
+    List<LockProfile *> *profiles;
+    unsigned numProfiles;
+};
+
+
+#endif
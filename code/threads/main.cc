@@ -11,8 +11,10 @@
 /// =====
 ///
 ///     nachos [-d <debugflags>] [-do <debugopts>] 
-///            [-rs <random seed #>] [-z] [-tt|-tN] 
-///            [-m <num phys pages>]
+///            [-rs <random seed #>] [-z] [-tt|-tN] [-tp <pool size>]
+///            [-se <stats file>]
+///            [-m <num phys pages>] [-mt <max threads>] [-rp <policy>]
+///            [-pw <low>,<high>]
 ///            [-s] [-x <nachos file>] [-tc <consoleIn> <consoleOut>] 
 ///            [-f] [-cp <unix file> <nachos file>] [-pr <nachos file>]
 ///            [-rm <nachos file>] [-ls] [-D] [-c] [-tf]
@@ -23,7 +25,15 @@
 /// * `-d`  -- causes certain debugging messages to be printed (cf.
 ///            `utility.hh`).
 /// * `-do` -- enables options that modify the behavior when printing
-///            debugging messages.
+///            debugging messages: `location`, `function`, `sleep` and
+///            `interactive`; also `profile`, which reports lock
+///            contention on halt, `lockdep`, which reports lock
+///            acquisitions in an order that may deadlock, `sched`,
+///            which reports scheduling statistics on halt, `slab`,
+///            which reports the usage of the slab allocator on halt, `pool`,
+///            which reports the reuse of thread stacks and control blocks
+///            on halt, to tune `-tp`, and `ring`, which keeps debugging
+///            messages in memory and prints them on halt.
 /// * `-rs` -- causes `Yield` to occur at random (but repeatable) spots.
 /// * `-z`  -- prints version and copyright information, and exits.
 /// * `-m`  -- size of emulated physical memory (in pages)
@@ -34,14 +44,31 @@
 /// * `-tt`  -- tests the threading subsystem; the user is asked to choose a
 ///            test to run from a collection of available tests.
 /// * `-tN` -- runs the Nth test.
+/// * `-tp`  -- maximum number of idle thread control blocks and stacks kept
+///            for reuse (0 disables the pool).
+/// * `-se`  -- writes scheduling statistics to the given host file on halt,
+///            as comma-separated records.
 ///
 /// *USER_PROGRAM* options
 /// ----------------------
 ///
 /// * `-s`  -- causes user programs to be executed in single-step mode.
+/// * `-mt` -- maximum number of threads alive at once (1024 by default).
 /// * `-x`  -- runs a user program.
 /// * `-tc` -- tests the console.
 ///
+/// *VMEM* options
+/// --------------
+///
+/// * `-rp` -- page replacement policy, with an optional parameter after a
+///            comma: `fifo`, `random`, `clock` (enhanced second chance, the
+///            default), `wsclock,<tau>` or `aging,<period>`; see
+///            `vmem/core_map.hh`.
+/// * `-pw` -- low and high watermarks of free frames for the pageout
+///            daemon, which frees frames in the background; by default an
+///            eighth and a quarter of physical memory.  A low watermark of
+///            0 disables it.  See `vmem/pageout_daemon.hh`.
+///
 /// *FILESYS* options
 /// -----------------
 ///
@@ -128,6 +155,8 @@ main(int argc, char **argv)
         if (!strcmp(*argv, "-tt")) {         // Test the threading subsystem.
             ThreadTest();
             interrupt->Halt();
+        } else if (!strcmp(*argv, "-tp")) {  // Handled in `Initialize`.
+            argCount = 2;
         } else {
             if (!strncmp(*argv, "-t",2)) {         // Select specific test
                 if(strncmp((*argv)+2, "c",1) && strncmp((*argv)+2, "f",1)){
@@ -0,0 +1,234 @@
+/// Routines for reader-writer locks.
+///
+/// Released locks are handed directly to the threads being woken up, as
+/// `Lock` does, so that no other thread can sneak in before they run.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "rw_lock.hh"
+#include "system.hh"
+
+#include <stdio.h>
+
+
+RWLock::RWLock(const char *debugName, RWPreference preference_)
+{
+    name       = debugName;
+    preference = preference_;
+    readers    = 0;
+    writer     = nullptr;
+    upgrader   = nullptr;
+    readWaiters  = new WaitQueue;
+    writeWaiters = new WaitQueue;
+    depClass = lockDep != nullptr ? lockDep->Register(name) : -1;
+    readAcquires  = readContended  = 0;
+    writeAcquires = writeContended = 0;
+    upgrades = failedUpgrades = downgrades = 0;
+    DEBUG('s', "RWLock %s created by %p\n", name, currentThread);
+}
+
+RWLock::~RWLock()
+{
+    ASSERT(readers == 0 && writer == nullptr);
+
+    DEBUG('s', "RWLock %s: %lu reads (%lu contended), "
+               "%lu writes (%lu contended), %lu upgrades "
+               "(%lu failed), %lu downgrades\n",
+          name, readAcquires, readContended, writeAcquires, writeContended,
+          upgrades, failedUpgrades, downgrades);
+    delete readWaiters;
+    delete writeWaiters;
+}
+
+const char *
+RWLock::GetName() const
+{
+    return name;
+}
+
+void
+RWLock::AcquireRead()
+{
+    if (lockDep != nullptr) {
+        lockDep->Acquire(depClass, __builtin_return_address(0));
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    readAcquires++;
+    bool mayEnter = writer == nullptr && upgrader == nullptr
+                    && (preference == RW_PREFER_READERS
+                        || writeWaiters->IsEmpty());
+    if (mayEnter) {
+        readers++;
+    } else {
+        readContended++;
+        readWaiters->Append(currentThread);
+        currentThread->Sleep();
+        // `GrantReaders` counted us in.
+    }
+
+    interrupt->SetLevel(oldLevel);
+    DEBUG('s', "RWLock %s acquired for reading by %p\n", name, currentThread);
+}
+
+void
+RWLock::ReleaseRead()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    ASSERT(readers > 0);
+    if (lockDep != nullptr) {
+        lockDep->Release(depClass);
+    }
+    readers--;
+    if (upgrader != nullptr && readers == 1) {
+        // Only the upgrader is left.
+        readers  = 0;
+        writer   = upgrader;
+        upgrader = nullptr;
+        scheduler->ReadyToRun(writer);
+    } else if (readers == 0) {
+        Grant(false);
+    }
+
+    interrupt->SetLevel(oldLevel);
+    DEBUG('s', "RWLock %s released for reading by %p\n", name, currentThread);
+}
+
+void
+RWLock::AcquireWrite()
+{
+    ASSERT(!IsWriteHeldByCurrentThread());
+
+    if (lockDep != nullptr) {
+        lockDep->Acquire(depClass, __builtin_return_address(0));
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    writeAcquires++;
+    if (writer == nullptr && readers == 0) {
+        writer = currentThread;
+    } else {
+        writeContended++;
+        writeWaiters->Append(currentThread);
+        currentThread->Sleep();
+    }
+    ASSERT(writer == currentThread);
+
+    interrupt->SetLevel(oldLevel);
+    DEBUG('s', "RWLock %s acquired for writing by %p\n", name, currentThread);
+}
+
+void
+RWLock::ReleaseWrite()
+{
+    ASSERT(IsWriteHeldByCurrentThread());
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    if (lockDep != nullptr) {
+        lockDep->Release(depClass);
+    }
+    writer = nullptr;
+    Grant(true);
+
+    interrupt->SetLevel(oldLevel);
+    DEBUG('s', "RWLock %s released for writing by %p\n", name, currentThread);
+}
+
+bool
+RWLock::Upgrade()
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    ASSERT(readers > 0);
+    if (upgrader != nullptr) {
+        failedUpgrades++;
+        interrupt->SetLevel(oldLevel);
+        return false;
+    }
+
+    upgrades++;
+    if (readers == 1) {
+        readers = 0;
+        writer  = currentThread;
+    } else {
+        upgrader = currentThread;
+        currentThread->Sleep();
+        // The last other reader made us the writer.
+    }
+    ASSERT(writer == currentThread);
+
+    interrupt->SetLevel(oldLevel);
+    DEBUG('s', "RWLock %s upgraded by %p\n", name, currentThread);
+    return true;
+}
+
+void
+RWLock::Downgrade()
+{
+    ASSERT(IsWriteHeldByCurrentThread());
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    downgrades++;
+    writer  = nullptr;
+    readers = 1;
+    if (preference != RW_PREFER_WRITERS || writeWaiters->IsEmpty()) {
+        GrantReaders();
+    }
+
+    interrupt->SetLevel(oldLevel);
+    DEBUG('s', "RWLock %s downgraded by %p\n", name, currentThread);
+}
+
+bool
+RWLock::IsWriteHeldByCurrentThread() const
+{
+    return writer == currentThread;
+}
+
+/// Assumes that interrupts are disabled and that nobody holds the lock.
+void
+RWLock::Grant(bool afterWrite)
+{
+    ASSERT(writer == nullptr && readers == 0);
+
+    bool readersFirst = preference == RW_PREFER_READERS
+                        || (preference == RW_FAIR && afterWrite);
+    if (readersFirst && !readWaiters->IsEmpty()) {
+        GrantReaders();
+    } else if (!writeWaiters->IsEmpty()) {
+        writer = writeWaiters->Pop();
+        scheduler->ReadyToRun(writer);
+    } else {
+        GrantReaders();
+    }
+}
+
+/// Assumes that interrupts are disabled.
+void
+RWLock::GrantReaders()
+{
+    Thread *thread;
+    while ((thread = readWaiters->Pop()) != nullptr) {
+        readers++;
+        scheduler->ReadyToRun(thread);
+    }
+}
+
+void
+RWLock::Print() const
+{
+    printf("RWLock %s: %u readers, writer %s\n", name, readers,
+           writer != nullptr ? writer->GetName() : "none");
+    printf("    reads: %lu, contended %lu\n", readAcquires, readContended);
+    printf("    writes: %lu, contended %lu\n", writeAcquires, writeContended);
+    printf("    upgrades: %lu, failed %lu; downgrades: %lu\n",
+           upgrades, failedUpgrades, downgrades);
+}
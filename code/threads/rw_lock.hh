@@ -0,0 +1,116 @@
+/// Reader-writer locks, a synchronization primitive
+///
+/// A reader-writer lock can be held either by any number of readers at the
+/// same time, or by a single writer.  It suits data that is looked up much
+/// more often than it is modified, such as files and directories.
+///
+/// When both readers and writers are waiting, the lock's preference decides
+/// who goes first:
+///
+/// * `RW_PREFER_READERS`: new readers join the current ones even if writers
+///   are waiting.  Best throughput for readers, but writers may starve.
+/// * `RW_PREFER_WRITERS`: new readers wait while a writer is waiting, and
+///   released locks go to writers first.  Readers may starve.
+/// * `RW_FAIR`: new readers wait behind waiting writers, but when a writer
+///   releases the lock, every reader waiting at that moment gets it.
+///   Neither side starves.
+///
+/// A reader can `Upgrade` to writer without letting any other writer in
+/// between, and a writer can `Downgrade` to reader without letting any
+/// writer in between.
+///
+/// Unlike `Lock`, reader-writer locks do not donate priority: readers are
+/// not tracked individually.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_RWLOCK__HH
+#define NACHOS_THREADS_RWLOCK__HH
+
+
+#include "wait_queue.hh"
+
+
+enum RWPreference {
+    RW_PREFER_READERS,
+    RW_PREFER_WRITERS,
+    RW_FAIR
+};
+
+class RWLock {
+public:
+
+    /// Constructor: set up the lock as free.
+    RWLock(const char *debugName, RWPreference preference = RW_FAIR);
+
+    /// Assume no one holds the lock nor is waiting for it.
+    ~RWLock();
+
+    /// For debugging.
+    const char *GetName() const;
+
+    /// Operations on the lock.
+    ///
+    /// All of them must be *atomic*.
+
+    void AcquireRead();
+    void ReleaseRead();
+    void AcquireWrite();
+    void ReleaseWrite();
+
+    /// Turn a read hold of the current thread into a write hold.
+    ///
+    /// Waits for the other readers to leave; no writer gets the lock
+    /// meanwhile.  If another reader is already waiting to upgrade, the two
+    /// would wait for each other forever, so return false instead; the
+    /// caller still holds the lock for reading, and has to release it and
+    /// call `AcquireWrite`.
+    bool Upgrade();
+
+    /// Turn the write hold of the current thread into a read hold.
+    void Downgrade();
+
+    /// Returns `true` if the current thread holds the lock for writing.
+    bool IsWriteHeldByCurrentThread() const;
+
+    /// Print usage and contention counters.
+    void Print() const;
+
+private:
+
+    /// For debugging.
+    const char *name;
+
+    RWPreference preference;
+
+    /// Number of threads holding the lock for reading.
+    unsigned readers;
+
+    /// Thread holding the lock for writing, null if none.
+    Thread *writer;
+
+    /// Reader waiting in `Upgrade`, null if none.
+    Thread *upgrader;
+
+    WaitQueue *readWaiters;
+    WaitQueue *writeWaiters;
+
+    /// Class of the lock for `lockDep`, -1 if not validated.
+    int depClass;
+
+    /// Counters.  An acquisition is contended if the thread had to wait.
+    unsigned long readAcquires, readContended;
+    unsigned long writeAcquires, writeContended;
+    unsigned long upgrades, failedUpgrades, downgrades;
+
+    /// Give the lock, which is free, to the next waiters.
+    void Grant(bool afterWrite);
+
+    /// Give the lock to every waiting reader.
+    void GrantReaders();
+};
+
+
+#endif
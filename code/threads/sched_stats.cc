@@ -0,0 +1,298 @@
+/// Routines to collect scheduling statistics.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "sched_stats.hh"
+#include "system.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+
+static const unsigned long FIRST_TIMELINE_INTERVAL = 100;
+
+static char *
+CopyName(const char *name)
+{
+    char *copy = new char [strlen(name) + 1];
+    strcpy(copy, name);
+    return copy;
+}
+
+SchedStats::SchedStats(bool print_, const char *exportFile_)
+{
+    print      = print_;
+    exportFile = exportFile_ != nullptr ? CopyName(exportFile_) : nullptr;
+
+    voluntarySwitches = involuntarySwitches = 0;
+    for (unsigned i = 0; i < LATENCY_BUCKETS; i++) {
+        latency[i] = 0;
+    }
+    latencySamples = totalLatency = maxLatency = 0;
+
+    for (unsigned i = 0; i <= MAX_LENGTH; i++) {
+        lengthTicks[i] = 0;
+    }
+    length = maxLength = 0;
+    lastLengthChange = stats->totalTicks;
+
+    for (unsigned i = 0; i < TIMELINE_SLOTS; i++) {
+        timeline[i] = 0;
+    }
+    timelineUsed     = 0;
+    timelineStart    = stats->totalTicks;
+    timelineInterval = FIRST_TIMELINE_INTERVAL;
+
+    records = new List<ThreadRecord *>;
+}
+
+static void
+DeleteRecord(SchedStats::ThreadRecord *record)
+{
+    delete [] record->name;
+    delete record;
+}
+
+SchedStats::~SchedStats()
+{
+    records->Apply(DeleteRecord);
+    delete records;
+    delete [] exportFile;
+}
+
+void
+SchedStats::Switch(Thread *oldThread, Thread *nextThread)
+{
+    ASSERT(oldThread != nullptr && nextThread != nullptr);
+    ASSERT(nextThread->GetStatus() == READY);
+
+    if (oldThread->GetStatus() == READY) {
+        involuntarySwitches++;
+    } else {
+        voluntarySwitches++;
+    }
+
+    unsigned long now = stats->totalTicks;
+    unsigned long since = nextThread->GetStatusSince();
+    unsigned long wait = now >= since ? now - since : 0;
+    unsigned bucket = 0;
+    for (unsigned long w = wait; w > 0 && bucket < LATENCY_BUCKETS - 1;
+         w >>= 1) {
+        bucket++;
+    }
+    latency[bucket]++;
+    latencySamples++;
+    totalLatency += wait;
+    if (wait > maxLatency) {
+        maxLatency = wait;
+    }
+}
+
+void
+SchedStats::ReadyLength(unsigned newLength)
+{
+    unsigned long now = stats->totalTicks;
+    if (now >= lastLengthChange) {
+        unsigned i = length < MAX_LENGTH ? length : MAX_LENGTH;
+        lengthTicks[i] += now - lastLengthChange;
+    }
+    lastLengthChange = now;
+    length = newLength;
+    if (length > maxLength) {
+        maxLength = length;
+    }
+
+    if (now < timelineStart) {
+        return;  // The tick counter was reset; stop the timeline.
+    }
+    unsigned long slot = (now - timelineStart) / timelineInterval;
+    while (slot >= TIMELINE_SLOTS) {
+        for (unsigned i = 0; i < TIMELINE_SLOTS / 2; i++) {
+            unsigned a = timeline[2 * i], b = timeline[2 * i + 1];
+            timeline[i] = a > b ? a : b;
+        }
+        for (unsigned i = TIMELINE_SLOTS / 2; i < TIMELINE_SLOTS; i++) {
+            timeline[i] = 0;
+        }
+        timelineUsed = DivRoundUp(timelineUsed, 2u);
+        timelineInterval *= 2;
+        slot = (now - timelineStart) / timelineInterval;
+    }
+    if (length > timeline[slot]) {
+        timeline[slot] = length;
+    }
+    if (slot + 1 > timelineUsed) {
+        timelineUsed = slot + 1;
+    }
+}
+
+SchedStats::ThreadRecord *
+SchedStats::FindRecord(const char *name) const
+{
+    struct Search {
+        const char *name;
+        ThreadRecord *result;
+
+        static void
+        Match(ThreadRecord *record, void *search_)
+        {
+            Search *search = (Search *) search_;
+            if (search->result == nullptr
+                  && strcmp(record->name, search->name) == 0) {
+                search->result = record;
+            }
+        }
+    };
+
+    Search search = { name, nullptr };
+    records->Apply(Search::Match, &search);
+    return search.result;
+}
+
+void
+SchedStats::AddThread(ThreadRecord *record, const Thread *thread)
+{
+    record->instances++;
+    record->running     += thread->GetStatusTicks(RUNNING);
+    record->ready       += thread->GetStatusTicks(READY);
+    record->blocked     += thread->GetStatusTicks(BLOCKED);
+    record->voluntary   += thread->GetSwitches(true);
+    record->involuntary += thread->GetSwitches(false);
+}
+
+void
+SchedStats::ThreadDone(const Thread *thread)
+{
+    ASSERT(thread != nullptr);
+
+    ThreadRecord *record = FindRecord(thread->GetName());
+    if (record == nullptr) {
+        record = new ThreadRecord;
+        record->name      = CopyName(thread->GetName());
+        record->instances = 0;
+        record->running   = record->ready = record->blocked = 0;
+        record->voluntary = record->involuntary = 0;
+        records->Append(record);
+    }
+    AddThread(record, thread);
+}
+
+/// Lowest latency counted in `bucket`.
+static unsigned long
+BucketLow(unsigned bucket)
+{
+    return bucket == 0 ? 0 : 1ul << (bucket - 1);
+}
+
+static void
+PrintRecord(SchedStats::ThreadRecord *r)
+{
+    printf("    %-20s x%-3u running %8lu, ready %8lu, blocked %8lu; "
+           "switches %lu/%lu\n", r->name, r->instances, r->running,
+           r->ready, r->blocked, r->voluntary, r->involuntary);
+}
+
+void
+SchedStats::PrintSummary() const
+{
+    printf("Scheduler: switches %lu voluntary, %lu involuntary\n",
+           voluntarySwitches, involuntarySwitches);
+
+    printf("    wakeup latency: %lu samples, mean %lu, max %lu ticks\n",
+           latencySamples,
+           latencySamples > 0 ? totalLatency / latencySamples : 0,
+           maxLatency);
+    for (unsigned i = 0; i < LATENCY_BUCKETS; i++) {
+        if (latency[i] == 0) {
+            continue;
+        }
+        if (i == 0) {
+            printf("        %10lu       : %lu\n", 0ul, latency[i]);
+        } else if (i == LATENCY_BUCKETS - 1) {
+            printf("        %10lu and up: %lu\n", BucketLow(i), latency[i]);
+        } else {
+            printf("        %10lu-%-6lu: %lu\n",
+                   BucketLow(i), BucketLow(i + 1) - 1, latency[i]);
+        }
+    }
+
+    unsigned long total = 0, weighted = 0;
+    for (unsigned i = 0; i <= MAX_LENGTH; i++) {
+        total    += lengthTicks[i];
+        weighted += lengthTicks[i] * i;
+    }
+    printf("    ready list length: max %u, mean %.2f\n", maxLength,
+           total > 0 ? (double) weighted / total : 0.0);
+
+    printf("    threads (ticks; voluntary/involuntary switches):\n");
+    records->Apply(PrintRecord);
+}
+
+/// Write `r` to the file `f_`.
+static void
+ExportRecord(SchedStats::ThreadRecord *r, void *f_)
+{
+    fprintf((FILE *) f_, "thread,%s,%u,%lu,%lu,%lu,%lu,%lu\n", r->name,
+            r->instances, r->running, r->ready, r->blocked,
+            r->voluntary, r->involuntary);
+}
+
+bool
+SchedStats::Export(const char *fileName) const
+{
+    FILE *f = fopen(fileName, "w");
+    if (f == nullptr) {
+        return false;
+    }
+
+    fprintf(f, "# kind,fields...\n");
+    fprintf(f, "ticks,%lu\n", stats->totalTicks);
+    fprintf(f, "switches,%lu,%lu\n", voluntarySwitches, involuntarySwitches);
+
+    fprintf(f, "# latency,low,high,count (high -1 means unbounded)\n");
+    for (unsigned i = 0; i < LATENCY_BUCKETS; i++) {
+        long high = i == LATENCY_BUCKETS - 1 ? -1
+                    : i == 0                 ? 0
+                    : (long) BucketLow(i + 1) - 1;
+        fprintf(f, "latency,%lu,%ld,%lu\n", BucketLow(i), high, latency[i]);
+    }
+
+    fprintf(f, "# ready_length,length,ticks (last length means or more)\n");
+    for (unsigned i = 0; i <= MAX_LENGTH; i++) {
+        fprintf(f, "ready_length,%u,%lu\n", i, lengthTicks[i]);
+    }
+
+    fprintf(f, "# ready_timeline,start tick,max length\n");
+    for (unsigned i = 0; i < timelineUsed; i++) {
+        fprintf(f, "ready_timeline,%lu,%u\n",
+                timelineStart + i * timelineInterval, timeline[i]);
+    }
+
+    fprintf(f, "# thread,name,instances,running,ready,blocked,"
+               "voluntary,involuntary\n");
+    records->Apply(ExportRecord, f);
+
+    fclose(f);
+    return true;
+}
+
+void
+SchedStats::Report()
+{
+    // Close the current stretch of the ready list length.
+    ReadyLength(length);
+    if (currentThread != nullptr) {
+        ThreadDone(currentThread);
+    }
+
+    if (print) {
+        PrintSummary();
+    }
+    if (exportFile != nullptr && !Export(exportFile)) {
+        fprintf(stderr, "Could not write scheduler statistics to %s\n",
+                exportFile);
+    }
+}
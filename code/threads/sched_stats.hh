@@ -0,0 +1,106 @@
+/// Scheduling statistics.
+///
+/// Threads account the time they spend running, ready and blocked by
+/// themselves (see `Thread::SetStatus`).  On top of that, when enabled
+/// with the `sched` debug option (`-do sched`) or an export file (`-se`),
+/// the scheduler feeds this collector with:
+///
+/// * wakeup latency: how long threads wait in the ready list before they
+///   run, as a histogram with power-of-two buckets;
+/// * context switches, voluntary (the thread blocked or finished) and
+///   involuntary (it was still ready, because it yielded or was preempted);
+/// * the length of the ready list over time: ticks spent at each length,
+///   and a timeline of the maximum length per interval.
+///
+/// Per-thread figures are added up by thread name when threads are
+/// destroyed.  Everything is reported when the machine halts: as a summary
+/// on the console, and as comma-separated records in the export file, one
+/// per line, with the kind of record first.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_SCHEDSTATS__HH
+#define NACHOS_THREADS_SCHEDSTATS__HH
+
+
+#include "lib/list.hh"
+
+
+class Thread;
+
+class SchedStats {
+public:
+
+    /// Per-thread figures, added up by name.
+    struct ThreadRecord {
+        char *name;
+        unsigned instances;
+        unsigned long running, ready, blocked;
+        unsigned long voluntary, involuntary;
+    };
+
+    /// * `print` tells whether to print a summary on halt.
+    /// * `exportFile` is the host file to write the records to, or null.
+    SchedStats(bool print, const char *exportFile);
+
+    ~SchedStats();
+
+    /// The scheduler is switching from `oldThread`, whose status is already
+    /// set, to `nextThread`, which is still ready.
+    void Switch(Thread *oldThread, Thread *nextThread);
+
+    /// The ready list now holds `length` threads.
+    void ReadyLength(unsigned length);
+
+    /// `thread` is being destroyed; keep its figures.
+    void ThreadDone(const Thread *thread);
+
+    /// Print the summary and write the export file, as requested.  The
+    /// current thread, which is never destroyed before halting, is counted
+    /// here.
+    void Report();
+
+private:
+
+    static const unsigned LATENCY_BUCKETS = 16;
+    static const unsigned MAX_LENGTH = 16;
+    static const unsigned TIMELINE_SLOTS = 128;
+
+    bool print;
+    char *exportFile;
+
+    unsigned long voluntarySwitches, involuntarySwitches;
+
+    /// Bucket 0 counts latencies of 0 ticks; bucket `i` those between
+    /// `2^(i-1)` and `2^i - 1`; the last one, everything beyond.
+    unsigned long latency[LATENCY_BUCKETS];
+    unsigned long latencySamples, totalLatency, maxLatency;
+
+    /// Ticks spent with each ready list length; the last entry covers
+    /// `MAX_LENGTH` and longer.
+    unsigned long lengthTicks[MAX_LENGTH + 1];
+    unsigned length, maxLength;
+    unsigned long lastLengthChange;
+
+    /// Maximum length in each interval of `timelineInterval` ticks since
+    /// `timelineStart`.  When the slots run out, pairs of them are merged
+    /// and the interval doubles, so the timeline covers the whole run.
+    unsigned timeline[TIMELINE_SLOTS];
+    unsigned timelineUsed;
+    unsigned long timelineStart, timelineInterval;
+
+    List<ThreadRecord *> *records;
+
+    static void AddThread(ThreadRecord *record, const Thread *thread);
+
+    ThreadRecord *FindRecord(const char *name) const;
+
+    void PrintSummary() const;
+
+    bool Export(const char *fileName) const;
+};
+
+
+#endif
@@ -28,8 +28,9 @@
 Scheduler::Scheduler()
 {
     for (unsigned i = 0; i <= MAX_PRIORITY; i++) {
-        readyList[i] = new List<Thread *>;
+        readyList[i] = new IntrusiveList<Thread, &Thread::queueLink>;
     }
+    numReady = 0;
 }
 
 /// De-allocate the list of ready threads.
@@ -53,19 +54,32 @@ Scheduler::ReadyToRun(Thread *thread)
 
     thread->SetStatus(READY);
     readyList[thread->GetPriority()]->Append(thread);
+    ChangeReadyCount(1);
+}
+
+void
+Scheduler::ChangeReadyCount(int delta)
+{
+    numReady += delta;
+    if (schedStats != nullptr) {
+        schedStats->ReadyLength(numReady);
+    }
 }
 
 /// Return the next thread to be scheduled onto the CPU.
 ///
-/// If there are no ready threads, return null.
+/// If there are no ready threads of priority `minPriority` or higher,
+/// return null.
 ///
 /// Side effect: thread is removed from the ready list.
 Thread *
-Scheduler::FindNextToRun()
+Scheduler::FindNextToRun(unsigned minPriority)
 {
-    for (int i = MAX_PRIORITY; i >= 0; i--) {
-        if (!readyList[i]->IsEmpty())
+    for (int i = MAX_PRIORITY; i >= (int) minPriority; i--) {
+        if (!readyList[i]->IsEmpty()) {
+            ChangeReadyCount(-1);
             return readyList[i]->Pop();
+        }
     }
 
     return nullptr;
@@ -100,6 +114,13 @@ Scheduler::Run(Thread *nextThread)
     oldThread->CheckOverflow();  // Check if the old thread had an undetected
                                  // stack overflow.
 
+    // The old thread is voluntarily giving up the processor unless it is
+    // still ready.
+    oldThread->CountSwitch(oldThread->GetStatus() != READY);
+    if (schedStats != nullptr) {
+        schedStats->Switch(oldThread, nextThread);
+    }
+
     currentThread = nextThread;  // Switch to the next thread.
     currentThread->SetStatus(RUNNING);  // `nextThread` is now running.
 
@@ -153,13 +174,24 @@ Scheduler::Print()
     }
 }
 
+/// Change the (effective) priority of `thread`.
+///
+/// If the thread is waiting on the ready list, move it to the queue of its
+/// new priority.  Running and blocked threads just have their priority
+/// updated; it takes effect the next time they are made ready.
+///
+/// Assumes that interrupts are disabled.
 void
 Scheduler::ChangePriority(Thread *thread, unsigned newPriority)
 {
-    thread->SetPriority(newPriority);
-    if (readyList[thread->GetOriginalPriority()]->Has(thread))
-    {
-        readyList[thread->GetOriginalPriority()]->Remove(thread);
+    ASSERT(thread != nullptr);
+
+    if (thread->GetStatus() == READY) {
+        readyList[thread->GetPriority()]->Remove(thread);
+        ChangeReadyCount(-1);
+        thread->SetPriority(newPriority);
+        ReadyToRun(thread);
+    } else {
+        thread->SetPriority(newPriority);
     }
-    ReadyToRun(thread);
 }
@@ -12,7 +12,7 @@
 
 
 #include "thread.hh"
-#include "lib/list.hh"
+#include "lib/intrusive_list.hh"
 
 
 /// The following class defines the scheduler/dispatcher abstraction --
@@ -31,7 +31,9 @@ public:
     void ReadyToRun(Thread *thread);
 
     /// Dequeue first thread on the ready list, if any, and return thread.
-    Thread *FindNextToRun();
+    ///
+    /// Only threads of priority `minPriority` or higher are considered.
+    Thread *FindNextToRun(unsigned minPriority = 0);
 
     /// Cause `nextThread` to start running.
     void Run(Thread *nextThread);
@@ -44,7 +46,13 @@ public:
 private:
 
     // List of Queues of threads that are ready to run, but not running.
-    List<Thread*> *readyList[MAX_PRIORITY + 1];
+    IntrusiveList<Thread, &Thread::queueLink> *readyList[MAX_PRIORITY + 1];
+
+    /// Number of threads in all of the ready lists.
+    unsigned numReady;
+
+    /// Update `numReady`, and tell `schedStats`.
+    void ChangeReadyCount(int delta);
 
 };
 
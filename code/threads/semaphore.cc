@@ -23,17 +23,19 @@
 
 #include "semaphore.hh"
 #include "system.hh"
+#include "lib/slab.hh"
 
 
 /// Initialize a semaphore, so that it can be used for synchronization.
 ///
 /// * `debugName` is an arbitrary name, useful for debugging.
 /// * `initialValue` is the initial value of the semaphore.
-Semaphore::Semaphore(const char *debugName, int initialValue)
+Semaphore::Semaphore(const char *debugName, int initialValue,
+                     WaitPolicy policy)
 {
     name  = debugName;
     value = initialValue;
-    queue = new List<Thread *>;
+    queue = new WaitQueue(policy);
 }
 
 /// De-allocate semaphore, when no longer needed.
@@ -44,6 +46,27 @@ Semaphore::~Semaphore()
     delete queue;
 }
 
+/// Cache for `Semaphore` objects, built on first use.
+static SlabCache &
+SemaphoreCache()
+{
+    static SlabCache cache("Semaphore", sizeof (Semaphore));
+    return cache;
+}
+
+void *
+Semaphore::operator new(size_t size)
+{
+    ASSERT(size == sizeof (Semaphore));
+    return SemaphoreCache().Alloc();
+}
+
+void
+Semaphore::operator delete(void *p)
+{
+    SemaphoreCache().Free(p);
+}
+
 const char *
 Semaphore::GetName() const
 {
@@ -72,6 +95,35 @@ Semaphore::P()
     interrupt->SetLevel(oldLevel);  // Re-enable interrupts.
 }
 
+/// Wait both in the semaphore queue and in the sleep queue, and check the
+/// value again whenever either of them wakes the thread up.
+bool
+Semaphore::TimedP(unsigned long ticks)
+{
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    // Once the alarm takes the sleeper out of the queue, its wake up time
+    // is no longer moved if the tick counter is reset, so `expired` is
+    // checked as well as the clock.
+    Sleeper sleeper = {
+        currentThread, stats->totalTicks + ticks, queue, false
+    };
+    while (value == 0 && !sleeper.expired
+             && stats->totalTicks < sleeper.when) {
+        queue->Append(currentThread);
+        sleepQueue->Add(&sleeper);
+        currentThread->Sleep();
+        sleepQueue->Remove(&sleeper);
+    }
+    bool acquired = value > 0;
+    if (acquired) {
+        value--;
+    }
+
+    interrupt->SetLevel(oldLevel);
+    return acquired;
+}
+
 /// Increment semaphore value, waking up a waiter if necessary.
 ///
 /// As with `P`, this operation must be atomic, so we need to disable
@@ -20,8 +20,7 @@
 #define NACHOS_THREADS_SEMAPHORE__HH
 
 
-#include "thread.hh"
-#include "lib/list.hh"
+#include "wait_queue.hh"
 
 
 /// This class defines a “semaphore”, which has a positive integer as its
@@ -41,11 +40,16 @@ public:
 
     /// Constructor: give an initial value to the semaphore.
     ///
-    /// Set initial value.
-    Semaphore(const char *debugName, int initialValue);
+    /// Set initial value.  `policy` decides which waiter `V` wakes up.
+    Semaphore(const char *debugName, int initialValue,
+              WaitPolicy policy = WAIT_PRIORITY);
 
     ~Semaphore();
 
+    /// Semaphores come from a slab cache.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     /// For debugging.
     const char *GetName() const;
 
@@ -55,6 +59,11 @@ public:
     void P();
     void V();
 
+    /// Like `P`, but give up after waiting for `ticks` ticks.
+    ///
+    /// Return whether the semaphore was decremented.
+    bool TimedP(unsigned long ticks);
+
 private:
 
     /// For debugging.
@@ -64,7 +73,7 @@ private:
     int value;
 
     /// Queue of threads waiting on `P` because the value is zero.
-    List<Thread *> *queue;
+    WaitQueue *queue;
 
 };
 
@@ -0,0 +1,129 @@
+/// Routines to manage sleeping threads.
+///
+/// Pending interrupts cannot be cancelled, so when a sleeper earlier than
+/// every scheduled alarm arrives, a new alarm is scheduled and the old one
+/// is left to fire with nothing to do.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "sleep_queue.hh"
+#include "system.hh"
+
+
+static void
+AlarmHandler(void *arg)
+{
+    ASSERT(arg != nullptr);
+    ((SleepQueue *) arg)->WakeUpDue();
+}
+
+SleepQueue::SleepQueue()
+{
+    sleepers  = new IntrusiveList<Sleeper, &Sleeper::link>;
+    nextAlarm = 0;
+}
+
+SleepQueue::~SleepQueue()
+{
+    delete sleepers;
+}
+
+/// Sleepers are compared by full wake up time, which may not fit an `int`
+/// list key.
+static bool
+WakesEarlier(const Sleeper *a, const Sleeper *b)
+{
+    return a->when < b->when;
+}
+
+void
+SleepQueue::Add(Sleeper *sleeper)
+{
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+    ASSERT(sleeper != nullptr && sleeper->thread != nullptr);
+    ASSERT(sleeper->when > stats->totalTicks);
+
+    sleeper->expired = false;
+    sleepers->SortedInsert(sleeper, WakesEarlier);
+    ScheduleAlarm();
+}
+
+void
+SleepQueue::Remove(Sleeper *sleeper)
+{
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+    ASSERT(sleeper != nullptr);
+
+    if (sleepers->Has(sleeper)) {
+        sleepers->Remove(sleeper);
+    }
+}
+
+bool
+SleepQueue::IsEmpty() const
+{
+    return sleepers->IsEmpty();
+}
+
+void
+SleepQueue::ScheduleAlarm()
+{
+    if (sleepers->IsEmpty()) {
+        return;
+    }
+    unsigned long when = sleepers->Head()->when;
+    if (nextAlarm == 0 || when < nextAlarm) {
+        // A sleeper can only be overdue here after a rebase.
+        unsigned long now = stats->totalTicks;
+        nextAlarm = when > now ? when : now + 1;
+        interrupt->Schedule(AlarmHandler, this, nextAlarm - now, ALARM_INT);
+    }
+}
+
+static void
+MoveEarlier(Sleeper *sleeper, void *offset_)
+{
+    unsigned long offset = *(unsigned long *) offset_;
+    sleeper->when = sleeper->when > offset ? sleeper->when - offset : 0;
+}
+
+/// The order of sleepers is kept, as they all move by the same amount.
+/// The pending alarm is moved by `Interrupt::RestartTicks` itself; if it is
+/// already due, it is forgotten, and at worst an extra alarm is scheduled.
+void
+SleepQueue::Rebase(unsigned long offset)
+{
+    sleepers->Apply(MoveEarlier, &offset);
+    nextAlarm = nextAlarm > offset ? nextAlarm - offset : 0;
+}
+
+void
+SleepQueue::WakeUpDue()
+{
+    unsigned long now = stats->totalTicks;
+    if (nextAlarm != 0 && nextAlarm <= now) {
+        nextAlarm = 0;
+    }
+
+    while (!sleepers->IsEmpty() && sleepers->Head()->when <= now) {
+        Sleeper *sleeper = sleepers->Pop();
+        WaitQueue *queue = sleeper->alsoIn;
+        if (queue == nullptr || queue->Has(sleeper->thread)) {
+            // Still blocked: time is up.
+            if (queue != nullptr) {
+                queue->Remove(sleeper->thread);
+            }
+            sleeper->expired = true;
+            DEBUG('t', "Waking up thread \"%s\" at tick %lu\n",
+                  sleeper->thread->GetName(), now);
+            scheduler->ReadyToRun(sleeper->thread);
+        }
+        // Otherwise the primitive already woke the thread up, and it just
+        // has not run yet.
+    }
+
+    ScheduleAlarm();
+}
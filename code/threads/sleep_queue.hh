@@ -0,0 +1,86 @@
+/// Data structures for threads sleeping until a given time.
+///
+/// Threads put themselves in the sleep queue together with the time at
+/// which they must be woken up.  The queue keeps a hardware alarm scheduled
+/// with the `Interrupt` simulation for the earliest of those times, so
+/// sleeping costs nothing until it is due, and the machine idles until then
+/// if nothing else is ready.
+///
+/// A sleeper may at the same time be waiting in the `WaitQueue` of a
+/// synchronization primitive, as timed waits do.  Whichever comes first,
+/// the primitive or the alarm, wakes the thread up; the other one then
+/// leaves it alone.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_SLEEPQUEUE__HH
+#define NACHOS_THREADS_SLEEPQUEUE__HH
+
+
+#include "wait_queue.hh"
+#include "lib/intrusive_list.hh"
+
+
+/// A thread in the sleep queue.  Sleepers live in the stack of the thread
+/// they describe, for as long as it sleeps.
+struct Sleeper {
+
+    Thread *thread;
+
+    /// Time at which to wake up, in ticks.
+    unsigned long when;
+
+    /// Queue of the primitive the thread is also waiting on, if any.
+    WaitQueue *alsoIn;
+
+    /// Set when the alarm, rather than the primitive, woke the thread up.
+    bool expired;
+
+    /// Link in the sleep queue.
+    ListLink<Sleeper> link;
+};
+
+class SleepQueue {
+public:
+
+    SleepQueue();
+
+    /// Assume nobody is sleeping.
+    ~SleepQueue();
+
+    /// Put `sleeper` in the queue.  The caller goes to sleep afterwards.
+    ///
+    /// Assumes that interrupts are disabled.
+    void Add(Sleeper *sleeper);
+
+    /// Take `sleeper` out of the queue, if still there.
+    ///
+    /// Assumes that interrupts are disabled.
+    void Remove(Sleeper *sleeper);
+
+    /// Wake up every sleeper whose time has come.  Called from the alarm
+    /// interrupt handler.
+    void WakeUpDue();
+
+    /// Move every wake up time `offset` ticks earlier, for when the tick
+    /// counter is reset.
+    void Rebase(unsigned long offset);
+
+    bool IsEmpty() const;
+
+private:
+
+    /// Sleepers, sorted by wake up time.
+    IntrusiveList<Sleeper, &Sleeper::link> *sleepers;
+
+    /// Time of the earliest alarm known to be pending, zero if none.
+    unsigned long nextAlarm;
+
+    /// Make sure an alarm is due no later than the earliest sleeper.
+    void ScheduleAlarm();
+};
+
+
+#endif
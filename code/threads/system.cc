@@ -24,10 +24,19 @@
 Thread *currentThread;        ///< The thread we are running now.
 Thread *threadToBeDestroyed;  ///< The thread that just finished.
 Scheduler *scheduler;         ///< The ready list.
+SleepQueue *sleepQueue;       ///< Threads sleeping until a given time.
 Interrupt *interrupt;         ///< Interrupt status.
 Statistics *stats;            ///< Performance metrics.
 Timer *timer;                 ///< The hardware timer device, for invoking
                               ///< context switches.
+ThreadPool *threadPool;       ///< Recycled thread control blocks and
+                              ///< execution stacks.
+LockProfiler *lockProfiler;   ///< Lock contention statistics, only with
+                              ///< the `profile` debug option.
+LockDep *lockDep;             ///< Lock order validator, only with the
+                              ///< `lockdep` debug option.
+SchedStats *schedStats;       ///< Scheduling statistics, only with the
+                              ///< `sched` debug option or `-se`.
 
 #ifdef FILESYS_NEEDED
 FileSystem *fileSystem;
@@ -42,6 +51,13 @@ Machine *machine;  ///< User program memory and registers.
 SynchConsole *synchConsole;
 Bitmap *pages;
 Table<Thread *> *activeThreads;
+FutexTable *futexTable;  ///< Threads blocked on user-level futexes.
+#endif
+
+#ifdef SWAP
+CoreMap *coreMap;  ///< Owners of physical frames, and page replacement.
+SwapArea *swapArea;  ///< Where pages go while out of memory.
+PageoutDaemon *pageoutDaemon;  ///< Keeps frames free, if enabled.
 #endif
 
 // External definition, to allow us to take a pointer to this function.
@@ -94,6 +110,24 @@ ParseDebugOpts(char *s, DebugOpts *out)
         } else if (strcmp(token, "interactive") == 0
                      || strcmp(token, "i") == 0) {
             out->interactive = true;
+        } else if (strcmp(token, "profile") == 0
+                     || strcmp(token, "p") == 0) {
+            out->lockProfile = true;
+        } else if (strcmp(token, "lockdep") == 0
+                     || strcmp(token, "d") == 0) {
+            out->lockDep = true;
+        } else if (strcmp(token, "sched") == 0
+                     || strcmp(token, "c") == 0) {
+            out->schedStats = true;
+        } else if (strcmp(token, "slab") == 0
+                     || strcmp(token, "b") == 0) {
+            out->slabStats = true;
+        } else if (strcmp(token, "pool") == 0
+                     || strcmp(token, "o") == 0) {
+            out->poolStats = true;
+        } else if (strcmp(token, "ring") == 0
+                     || strcmp(token, "r") == 0) {
+            out->ring = true;
         } else {
             return false;  // Invalid option.
         }
@@ -123,13 +157,19 @@ Initialize(int argc, char **argv)
     const char *debugFlags = "";
     DebugOpts debugOpts;
     bool randomYield = false;
+    unsigned poolHighWater = DEFAULT_THREAD_POOL_HIGH_WATER;
+    const char *schedExport = nullptr;
 
 #ifdef USER_PROGRAM
     bool debugUserProg = false;  // Single step user program.
     int numPhysicalPages = DEFAULT_NUM_PHYS_PAGES;
-
-    activeThreads = new Table<Thread*>();
-    activeThreads->Add(currentThread);
+    unsigned maxThreads = DEFAULT_MAX_THREADS;
+#endif
+#ifdef SWAP
+    ReplacementPolicy replacement = REPLACE_CLOCK;
+    unsigned replacementParam = 0;  // Default for the policy.
+    bool pageoutGiven = false;
+    unsigned pageoutLow = 0, pageoutHigh = 0;
 #endif
 #ifdef FILESYS_NEEDED
     bool format = false;  // Format disk.
@@ -155,6 +195,14 @@ Initialize(int argc, char **argv)
               // Initialize pseudo-random number generator.
             randomYield = true;
             argCount = 2;
+        } else if (!strcmp(*argv, "-tp")) {
+            ASSERT(argc > 1);
+            poolHighWater = atoi(*(argv + 1));
+            argCount = 2;
+        } else if (!strcmp(*argv, "-se")) {
+            ASSERT(argc > 1);
+            schedExport = *(argv + 1);
+            argCount = 2;
         }
 #ifdef USER_PROGRAM
         if (!strcmp(*argv, "-s")) {
@@ -165,6 +213,27 @@ Initialize(int argc, char **argv)
             numPhysicalPages = atoi(*(argv + 1));
             argCount = 2;
         }
+        if (!strcmp(*argv, "-mt")) {
+            ASSERT(argc > 1);
+            maxThreads = atoi(*(argv + 1));
+            ASSERT(maxThreads > 1 && maxThreads <= Table<Thread *>::MAX_SIZE);
+            argCount = 2;
+        }
+#endif
+#ifdef SWAP
+        if (!strcmp(*argv, "-rp")) {
+            ASSERT(argc > 1);
+            ASSERT(CoreMap::ParsePolicy(*(argv + 1), &replacement,
+                                        &replacementParam));
+            argCount = 2;
+        }
+        if (!strcmp(*argv, "-pw")) {
+            ASSERT(argc > 1);
+            ASSERT(PageoutDaemon::ParseWatermarks(*(argv + 1), &pageoutLow,
+                                                  &pageoutHigh));
+            pageoutGiven = true;
+            argCount = 2;
+        }
 #endif
 #ifdef FILESYS_NEEDED
         if (!strcmp(*argv, "-f")) {
@@ -172,15 +241,35 @@ Initialize(int argc, char **argv)
         }
 #endif
     }
+    #ifdef SWAP
+    coreMap = new CoreMap(numPhysicalPages, replacement, replacementParam);
+    #elif defined(USER_PROGRAM)
+    pages = new Bitmap(numPhysicalPages);
+    #endif
     #ifdef USER_PROGRAM
-    pages = new Bitmap(numPhysicalPages);   
+
+    // Pid 0 is never given to a thread.
+    activeThreads = new Table<Thread*>(maxThreads);
+    activeThreads->Add(nullptr);
     #endif
 
     debug.SetFlags(debugFlags);  // Initialize `DEBUG` messages.
     debug.SetOpts(debugOpts);    // Set debugging behavior.
     stats = new Statistics;      // Collect statistics.
+    if (debugOpts.lockProfile) { // Before any lock is created.
+        lockProfiler = new LockProfiler;
+    }
+    if (debugOpts.lockDep) {
+        lockDep = new LockDep;
+    }
+    if (debugOpts.schedStats || schedExport != nullptr) {
+        schedStats = new SchedStats(debugOpts.schedStats, schedExport);
+    }
     interrupt = new Interrupt;   // Start up interrupt handling.
     scheduler = new Scheduler;   // Initialize the ready queue.
+    sleepQueue = new SleepQueue;
+    threadPool = new ThreadPool(poolHighWater);
+                                 // Pre-allocate threads and stacks.
     if (randomYield) {           // Start the timer (if needed).
         timer = new Timer(TimerInterruptHandler, 0, randomYield);
     }
@@ -202,6 +291,7 @@ Initialize(int argc, char **argv)
     machine = new Machine(d, numPhysicalPages);  // This must come first.
     SetExceptionHandlers();
     synchConsole = new SynchConsole();
+    futexTable = new FutexTable;
 #endif
 
 #ifdef FILESYS
@@ -212,6 +302,16 @@ Initialize(int argc, char **argv)
     fileSystem = new FileSystem(format);
 #endif
 
+#ifdef SWAP
+    swapArea = new SwapArea("SWAP");
+    if (!pageoutGiven) {
+        pageoutLow  = numPhysicalPages / 8;
+        pageoutHigh = numPhysicalPages / 4;
+    }
+    pageoutDaemon = pageoutLow > 0
+                    ? new PageoutDaemon(pageoutLow, pageoutHigh) : nullptr;
+#endif
+
 }
 
 /// Nachos is halting.  De-allocate global data structures.
@@ -220,9 +320,34 @@ Cleanup()
 {
     DEBUG('i', "Cleaning up...\n");
 
+    delete timer;
+    delete sleepQueue;
+    delete scheduler;
+    delete interrupt;
+
+    delete stats;
+    delete lockProfiler;
+    delete lockDep;
+    delete schedStats;
+    schedStats = nullptr;  // The threads deleted below must not use it.
+
+    //The thread destructor checks that currentThread != this
+    Thread *t = currentThread;
+    currentThread = NULL;
+    delete t; 
+
+    // After the thread: its address space gives frames and swap slots
+    // back, and its files are closed.
 #ifdef USER_PROGRAM
     delete machine;
     delete synchConsole;
+    delete futexTable;
+#endif
+
+#ifdef SWAP
+    delete pageoutDaemon;
+    delete coreMap;
+    delete swapArea;  // Before the file system.
 #endif
 
 #ifdef FILESYS_NEEDED
@@ -233,16 +358,7 @@ Cleanup()
     delete synchDisk;
 #endif
 
-    delete timer;
-    delete scheduler;
-    delete interrupt;
-
-    delete stats;
-
-    //The thread destructor checks that currentThread != this
-    Thread *t = currentThread;
-    currentThread = NULL;
-    delete t; 
+    delete threadPool;
 
     exit(0);
 }
@@ -11,6 +11,10 @@
 
 #include "thread.hh"
 #include "scheduler.hh"
+#include "sleep_queue.hh"
+#include "lock_profile.hh"
+#include "sched_stats.hh"
+#include "thread_pool.hh"
 #include "lib/utility.hh"
 #include "machine/interrupt.hh"
 #include "machine/statistics.hh"
@@ -29,20 +33,36 @@ extern void Cleanup();
 extern Thread *currentThread;        ///< The thread holding the CPU.
 extern Thread *threadToBeDestroyed;  ///< The thread that just finished.
 extern Scheduler *scheduler;         ///< The ready list.
+extern SleepQueue *sleepQueue;       ///< Threads waiting for some time.
 extern Interrupt *interrupt;         ///< Interrupt status.
 extern Statistics *stats;            ///< Performance metrics.
 extern Timer *timer;                 ///< The hardware alarm clock.
+extern ThreadPool *threadPool;       ///< Recycled threads and stacks.
+extern LockProfiler *lockProfiler;   ///< Lock statistics, if enabled.
+extern LockDep *lockDep;             ///< Lock order validator, if enabled.
+extern SchedStats *schedStats;       ///< Scheduling statistics, if enabled.
 
 #ifdef USER_PROGRAM
 #include "machine/machine.hh"
 #include "userprog/synch_console.hh"
 #include "lib/bitmap.hh"
 #include "lib/table.hh"
+#include "userprog/futex.hh"
 
 extern Machine *machine;  // User program memory and registers.
 extern SynchConsole *synchConsole;
 extern Bitmap *pages;
 extern Table<Thread *> *activeThreads;
+extern FutexTable *futexTable;
+#endif
+
+#ifdef SWAP
+#include "vmem/core_map.hh"
+#include "vmem/pageout_daemon.hh"
+#include "vmem/swap_area.hh"
+extern CoreMap *coreMap;
+extern SwapArea *swapArea;
+extern PageoutDaemon *pageoutDaemon;
 #endif
 
 #ifdef FILESYS_NEEDED  // *FILESYS* or *FILESYS_STUB*.
@@ -21,16 +21,12 @@
 #include "switch.h"
 #include "system.hh"
 #include "channel.hh"
+#include "lock.hh"
 
 #include <inttypes.h>
 #include <stdio.h>
 
 
-/// This is put at the top of the execution stack, for detecting stack
-/// overflows.
-const unsigned STACK_FENCEPOST = 0xDEADBEEF;
-
-
 static inline bool
 IsThreadStatus(ThreadStatus s)
 {
@@ -41,21 +37,35 @@ IsThreadStatus(ThreadStatus s)
 /// `Thread::Fork`.
 ///
 /// * `threadName` is an arbitrary string, useful for debugging.
-Thread::Thread(const char *threadName, int flag_, unsigned priority_)
+/// * `stackSize` is the size of the execution stack, in words.  Stacks
+///   larger than the default are only reserved on the host; their pages
+///   are committed as the thread touches them.
+Thread::Thread(const char *threadName, int flag_, unsigned priority_,
+               unsigned stackSize_)
 {
     ASSERT(priority_ <= MAX_PRIORITY && priority_ >= 0);
+    ASSERT(stackSize_ >= MIN_STACK_SIZE);
     joinFlag = flag_;
     name     = threadName;
     stackTop = nullptr;
     stack    = nullptr;
+    stackSize = stackSize_;
     status   = JUST_CREATED;
+    statusSince = stats != nullptr ? stats->totalTicks : 0;
+    for (unsigned i = 0; i < NUM_THREAD_STATUS; i++) {
+        statusTicks[i] = 0;
+    }
+    voluntarySwitches = involuntarySwitches = 0;
     priority = priority_;
     originalPriority = priority;
+    waitingLock = nullptr;
+    heldLocks = new List<Lock *>;
     channel  = new Channel(threadName);
 #ifdef USER_PROGRAM
-    fileTable = new Table<OpenFile *>();
+    fileTable = new Table<OpenFile *>(MAX_OPEN_FILES);
     pid = activeThreads->Add(this);
     space    = nullptr;
+    stackSlot = -1;
     TlbIndex = 0;
 #endif
 }
@@ -72,22 +82,65 @@ Thread::~Thread()
 {
     if (channel != nullptr)
         delete channel;
+    ASSERT(heldLocks->IsEmpty());
+    delete heldLocks;
     DEBUG('t', "Deleting thread \"%s\"\n", name);
 
     ASSERT(this != currentThread);
+    if (schedStats != nullptr) {
+        schedStats->ThreadDone(this);
+    }
     if (stack != nullptr) {
-        SystemDep::DeallocBoundedArray((char *) stack,
-                                       STACK_SIZE * sizeof *stack);
+        DEBUG('t', "Thread \"%s\" used %u of %u bytes of stack\n",
+              name, GetStackHighWater(), stackSize * sizeof *stack);
+        if (stackSize == STACK_SIZE) {
+            threadPool->PutStack(stack);
+        } else {
+            SystemDep::DeallocGuardedArray((char *) stack,
+                                           stackSize * sizeof *stack);
+        }
     }
 
     #ifdef USER_PROGRAM
-        if(space != nullptr) delete space;
+        if (space != nullptr) {
+            if (stackSlot != -1) {
+                space->FreeStack(stackSlot);
+            }
+            // Other threads of the program may still be using it.
+            if (space->RemoveReference()) {
+                delete space;
+            }
+        }
         delete fileTable;
         activeThreads->Remove(pid);
     #endif
 
 }
 
+/// Take the storage for a new thread from the pool.
+///
+/// The main thread is created before the pool exists, so fall back to the
+/// host allocator in that case.
+void *
+Thread::operator new(size_t size)
+{
+    ASSERT(size == sizeof (Thread));
+    if (threadPool == nullptr) {
+        return ::operator new(size);
+    }
+    return threadPool->GetThread();
+}
+
+/// Give the storage of a destroyed thread back to the pool.
+void
+Thread::operator delete(void *p)
+{
+    if (threadPool == nullptr) {
+        ::operator delete(p);
+        return;
+    }
+    threadPool->PutThread(p);
+}
 
 #ifdef USER_PROGRAM
 int
@@ -143,15 +196,68 @@ Thread::Join()
 void
 Thread::SetPriority(unsigned newPriority)
 {
+    ASSERT(newPriority <= MAX_PRIORITY);
     priority = newPriority;
 }
 
+Lock *
+Thread::GetWaitingLock() const
+{
+    return waitingLock;
+}
+
+void
+Thread::SetWaitingLock(Lock *lock)
+{
+    waitingLock = lock;
+}
+
+void
+Thread::AddHeldLock(Lock *lock)
+{
+    ASSERT(lock != nullptr);
+    heldLocks->Append(lock);
+}
+
+void
+Thread::RemoveHeldLock(Lock *lock)
+{
+    ASSERT(lock != nullptr);
+    heldLocks->Remove(lock);
+}
+
+/// Raise `*priority_` to that of the highest waiter on `lock`.
+static void
+InheritFrom(Lock *lock, void *priority_)
+{
+    unsigned *priority = (unsigned *) priority_;
+    unsigned p = lock->GetMaxWaiterPriority();
+    if (p > *priority) {
+        *priority = p;
+    }
+}
+
+/// Must be called with interrupts disabled, as the thread may have to move
+/// to a different ready queue.
+void
+Thread::RecomputePriority()
+{
+    ASSERT(interrupt->GetLevel() == INT_OFF);
+
+    unsigned inherited = originalPriority;
+    heldLocks->Apply(InheritFrom, &inherited);
+    if (inherited != priority) {
+        scheduler->ChangePriority(this, inherited);
+    }
+}
+
 /// Check a thread's stack to see if it has overrun the space that has been
-/// allocated for it.  If we had a smarter compiler, we would not need to
-/// worry about this, but we do not.
+/// allocated for it.
 ///
-/// NOTE: Nachos will not catch all stack overflow conditions.  In other
-/// words, your program may still crash because of an overflow.
+/// Actual overflows are caught by the guard page below every stack, which
+/// faults as soon as it is touched.  Here we only check that the running
+/// thread's stack pointer is still inside its stack, which also catches a
+/// thread that somehow ended up running on the wrong stack.
 ///
 /// If you get bizarre results (such as seg faults where there is no code)
 /// then you *may* need to increase the stack size.  You can avoid stack
@@ -161,18 +267,88 @@ Thread::SetPriority(unsigned newPriority)
 void
 Thread::CheckOverflow() const
 {
-    if (stack != nullptr) {
-        ASSERT(*stack == STACK_FENCEPOST);
+    if (stack != nullptr && this == currentThread) {
+        uintptr_t here;
+        ASSERT(&here > stack && &here < stack + stackSize);
+    }
+}
+
+unsigned
+Thread::GetStackSize() const
+{
+    return stackSize;
+}
+
+/// The host only commits the pages of a stack that have been touched, so
+/// the deepest committed page tells how far the stack has grown.
+///
+/// Returns 0 for the main thread, whose stack is not ours.
+unsigned
+Thread::GetStackHighWater() const
+{
+    if (stack == nullptr) {
+        return 0;
     }
+    return SystemDep::ResidentDepth((const char *) stack,
+                                    stackSize * sizeof *stack);
 }
 
 void
 Thread::SetStatus(ThreadStatus st)
 {
     ASSERT(IsThreadStatus(st));
+
+    if (st == status) {
+        return;  // Keep the stretch going, e.g. when moved between queues.
+    }
+    unsigned long now = stats->totalTicks;
+    if (now >= statusSince) {  // The tick counter may have been reset.
+        statusTicks[status] += now - statusSince;
+    }
+    statusSince = now;
     status = st;
 }
 
+ThreadStatus
+Thread::GetStatus() const
+{
+    return status;
+}
+
+unsigned long
+Thread::GetStatusTicks(ThreadStatus st) const
+{
+    ASSERT(IsThreadStatus(st));
+
+    unsigned long ticks = statusTicks[st];
+    if (st == status && stats->totalTicks >= statusSince) {
+        ticks += stats->totalTicks - statusSince;
+    }
+    return ticks;
+}
+
+unsigned long
+Thread::GetStatusSince() const
+{
+    return statusSince;
+}
+
+void
+Thread::CountSwitch(bool voluntary)
+{
+    if (voluntary) {
+        voluntarySwitches++;
+    } else {
+        involuntarySwitches++;
+    }
+}
+
+unsigned long
+Thread::GetSwitches(bool voluntary) const
+{
+    return voluntary ? voluntarySwitches : involuntarySwitches;
+}
+
 const char *
 Thread::GetName() const
 {
@@ -222,12 +398,15 @@ Thread::Finish()
     // Not reached.
 }
 
-/// Relinquish the CPU if any other thread is ready to run.
+/// Relinquish the CPU if any other thread of the same or higher priority is
+/// ready to run.
 ///
 /// If so, put the thread on the end of the ready list, so that it will
-/// eventually be re-scheduled.
+/// eventually be re-scheduled.  Threads of lower priority are passed over:
+/// a yield, even one forced by the timer, must not let them delay a thread
+/// of higher priority, or one running with a priority it inherited.
 ///
-/// NOTE: returns immediately if no other thread on the ready queue.
+/// NOTE: returns immediately if no such thread on the ready queue.
 /// Otherwise returns when the thread eventually works its way to the front
 /// of the ready list and gets re-scheduled.
 ///
@@ -246,7 +425,7 @@ Thread::Yield()
 
     DEBUG('t', "Yielding thread \"%s\"\n", GetName());
 
-    Thread *nextThread = scheduler->FindNextToRun();
+    Thread *nextThread = scheduler->FindNextToRun(GetPriority());
     if (nextThread != nullptr) {
         scheduler->ReadyToRun(this);
         scheduler->Run(nextThread);
@@ -278,7 +457,7 @@ Thread::Sleep()
     DEBUG('t', "Sleeping thread \"%s\"\n", GetName());
 
     Thread *nextThread;
-    status = BLOCKED;
+    SetStatus(BLOCKED);
     while ((nextThread = scheduler->FindNextToRun()) == nullptr) {
         interrupt->Idle();  // No one to run, wait for an interrupt.
     }
@@ -286,6 +465,30 @@ Thread::Sleep()
     scheduler->Run(nextThread);  // Returns when we have been signalled.
 }
 
+/// Block the current thread on the sleep queue until `ticks` ticks from
+/// now.  Other threads run meanwhile; if there are none, the machine idles
+/// until the alarm.
+void
+Thread::SleepFor(unsigned long ticks)
+{
+    ASSERT(this == currentThread);
+
+    if (ticks == 0) {
+        Yield();
+        return;
+    }
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    DEBUG('t', "Thread \"%s\" sleeping for %lu ticks\n", GetName(), ticks);
+    Sleeper sleeper = { this, stats->totalTicks + ticks, nullptr, false };
+    sleepQueue->Add(&sleeper);
+    Sleep();
+    ASSERT(sleeper.expired);
+
+    interrupt->SetLevel(oldLevel);
+}
+
 /// ThreadFinish, InterruptEnable
 ///
 /// Dummy functions because C++ does not allow a pointer to a member
@@ -318,19 +521,21 @@ Thread::StackAllocate(VoidFunctionPtr func, void *arg)
 {
     ASSERT(func != nullptr);
 
-    stack = (uintptr_t *)
-              SystemDep::AllocBoundedArray(STACK_SIZE * sizeof *stack);
+    if (stackSize == STACK_SIZE) {
+        stack = threadPool->GetStack();
+    } else {
+        stack = (uintptr_t *) SystemDep::AllocGuardedArray(
+                  stackSize * sizeof *stack, stackSize > STACK_SIZE);
+    }
 
     // Stacks in x86 work from high addresses to low addresses.
-    stackTop = stack + STACK_SIZE - 4;  // -4 to be on the safe side!
+    stackTop = stack + stackSize - 4;  // -4 to be on the safe side!
 
     // x86 passes the return address on the stack.  In order for `SWITCH` to
     // go to `ThreadRoot` when we switch to this thread, the return address
     // used in `SWITCH` must be the starting address of `ThreadRoot`.
     *--stackTop = (uintptr_t) ThreadRoot;
 
-    *stack = STACK_FENCEPOST;
-
     machineState[PCState]         = (uintptr_t) ThreadRoot;
     machineState[StartupPCState]  = (uintptr_t) InterruptEnable;
     machineState[InitialPCState]  = (uintptr_t) func;
@@ -350,6 +555,9 @@ void Thread::RemoveFile(int fileId)
 int Thread::AddFile(OpenFile *file)
 {
     int tmp = fileTable->Add(file);
+    if (tmp == -1) {
+        return -1;  // Too many open files.
+    }
     return tmp + 2; // Para evitar que nos devuelva 0 y 1 que estan reservados para la consola
 }
 bool Thread::HasFile(int fileId)
@@ -368,12 +576,26 @@ OpenFile *Thread::GetFile(int fileId)
 /// Note that a user program thread has *two* sets of CPU registers -- one
 /// for its state while executing user code, one for its state while
 /// executing kernel code.  This routine saves the former.
+///
+/// A thread switched out in the middle of its program's atomic sequence
+/// will start the sequence over, since other threads may touch the same
+/// memory before it resumes.
 void
 Thread::SaveUserState()
 {
     for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
         userRegisters[i] = machine->ReadRegister(i);
     }
+
+    unsigned pc = userRegisters[PC_REG];
+    unsigned restart = space->RestartPoint(pc);
+    if (restart != pc) {
+        DEBUG('e', "Restarting atomic sequence of thread \"%s\"\n", name);
+        userRegisters[PC_REG]      = restart;
+        userRegisters[NEXT_PC_REG] = restart + 4;
+        userRegisters[LOAD_REG]    = 0;
+        userRegisters[LOAD_VALUE_REG] = 0;
+    }
 }
 
 /// Restore the CPU state of a user program on a context switch.
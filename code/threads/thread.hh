@@ -21,8 +21,10 @@
 /// faults, so that is not a sure sign that your thread stacks are too
 /// small.)
 ///
-/// One thing to try if you find yourself with segmentation faults is to
-/// increase the size of thread stack -- `STACK_SIZE`.
+/// Stacks are preceded by a guard page, so an overflow faults at the
+/// offending instruction, in the overflowing thread.  One thing to try if
+/// you find yourself with segmentation faults is to increase the size of
+/// thread stack -- `STACK_SIZE`.
 ///
 /// In this interface, forking a thread takes two steps.  We must first
 /// allocate a data structure for it:
@@ -47,10 +49,14 @@
 #endif
 
 #include <stdint.h>
+#include "lib/list.hh"
+#include "lib/intrusive_list.hh"
 #include "lib/table.hh"
 #include "filesys/open_file.hh"
+#include "lock_dep.hh"
 
 class Channel;
+class Lock;
 
 /// CPU register state to be saved on context switch.
 ///
@@ -58,16 +64,30 @@ class Channel;
 /// registers.  We allocate room for the maximum of these two architectures.
 const unsigned MACHINE_STATE_SIZE = 17;
 
-/// Size of the thread's private execution stack.
+/// Default size of the thread's private execution stack.
 ///
-/// In words.
+/// In words.  Threads may ask for a different size when they are created;
+/// stacks of the default size are recycled through `threadPool`.
 ///
 /// WATCH OUT IF THIS IS NOT BIG ENOUGH!!!!!
 const unsigned STACK_SIZE = 4 * 1024;
 
+/// Smallest stack a thread may ask for, in words.
+///
+/// Enough for `ThreadRoot`, the context switch and a few calls, but not for
+/// `printf` and friends.
+const unsigned MIN_STACK_SIZE = 512;
+
 /// Levels of thread priorities
 const unsigned MAX_PRIORITY = 9;
 
+/// Default maximum number of threads alive at once, each with a pid in
+/// `activeThreads`; `-mt` changes it.
+const unsigned DEFAULT_MAX_THREADS = 1024;
+
+/// Maximum number of files a thread may have open at once.
+const unsigned MAX_OPEN_FILES = 64;
+
 /// Thread state.
 enum ThreadStatus {
     JUST_CREATED,
@@ -102,7 +122,8 @@ private:
 public:
 
     /// Initialize a `Thread`.
-    Thread(const char *debugName, int flag = 0, unsigned priority = 4);
+    Thread(const char *debugName, int flag = 0, unsigned priority = 4,
+           unsigned stackSize = STACK_SIZE);
 
     /// Deallocate a Thread.
     ///
@@ -110,6 +131,11 @@ public:
     /// called.
     ~Thread();
 
+    /// Thread control blocks are recycled through `threadPool`, so that
+    /// creating and destroying threads does not go to the host allocator.
+    static void *operator new(size_t size);
+    static void operator delete(void *p);
+
     /// Basic thread operations.
 
     /// Make thread run `(*func)(arg)`.
@@ -121,14 +147,40 @@ public:
     /// Put the thread to sleep and relinquish the processor.
     void Sleep();
 
+    /// Block the thread for `ticks` ticks of simulated time.
+    void SleepFor(unsigned long ticks);
+
     /// The thread is done executing.
     void Finish();
 
     /// Check if thread has overflowed its stack.
     void CheckOverflow() const;
 
+    /// Size of the thread's stack, in words.
+    unsigned GetStackSize() const;
+
+    /// How many bytes of its stack the thread has used so far, rounded up
+    /// to whole host pages.
+    unsigned GetStackHighWater() const;
+
+    /// Change the status of the thread, accounting the time spent in the
+    /// previous one.
     void SetStatus(ThreadStatus st);
 
+    ThreadStatus GetStatus() const;
+
+    /// Ticks spent with status `st`, including the current stretch.
+    unsigned long GetStatusTicks(ThreadStatus st) const;
+
+    /// When the thread got its current status.
+    unsigned long GetStatusSince() const;
+
+    /// Count a switch away from the thread: voluntary if it blocked or
+    /// finished, involuntary if it was still ready to run.
+    void CountSwitch(bool voluntary);
+
+    unsigned long GetSwitches(bool voluntary) const;
+
     const char *GetName() const;
 
     unsigned GetPriority();
@@ -141,23 +193,61 @@ public:
 
     void SetPriority(unsigned newPriority);
 
+    /// Priority inheritance bookkeeping, maintained by `Lock`.
+
+    /// Lock the thread is blocked on, if any.
+    Lock *GetWaitingLock() const;
+    void SetWaitingLock(Lock *lock);
+
+    void AddHeldLock(Lock *lock);
+    void RemoveHeldLock(Lock *lock);
+
+    /// Set the priority to the highest among the original one and those of
+    /// the waiters of every lock the thread holds.
+    void RecomputePriority();
+
+    /// Classes of the locks held, maintained by `lockDep` if enabled.
+    HeldLockClasses heldLockClasses;
+
+    /// Link in the ready list or the `WaitQueue` the thread is on; a thread
+    /// is never on more than one of them.
+    ListLink<Thread> queueLink;
+
 private:
     // Some of the private data for this class is listed above.
 
     /// Bottom of the stack.
     ///
     /// Null if this is the main thread.  (If null, do not deallocate stack.)
+    /// Otherwise it is preceded by a guard page, so running off the bottom
+    /// of the stack faults right away.
     uintptr_t *stack;
 
+    /// Size of the stack, in words.
+    unsigned stackSize;
+
     /// Ready, running or blocked.
     ThreadStatus status;
 
+    /// Time accounting per status, and switches away from the thread.
+    unsigned long statusSince;
+    unsigned long statusTicks[NUM_THREAD_STATUS];
+    unsigned long voluntarySwitches, involuntarySwitches;
+
     const char *name;
     Channel *channel;
     int joinFlag;
 
+    /// Effective priority (including donations) and the one the thread was
+    /// created with.
     unsigned priority, originalPriority;
 
+    /// Lock the thread is blocked on, null if none.
+    Lock *waitingLock;
+
+    /// Locks currently held by the thread.
+    List<Lock *> *heldLocks;
+
     /// Allocate a stack for thread.  Used internally by `Fork`.
     void StackAllocate(VoidFunctionPtr func, void *arg);
 
@@ -192,6 +282,10 @@ public:
     // User code this thread is running.
     AddressSpace *space;
 
+    // Stack slot in `space` of a thread created by `Fork`, or -1 for the
+    // main thread of the program.
+    int stackSlot;
+
     unsigned TlbIndex;
 #endif
 };
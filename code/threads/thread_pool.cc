@@ -0,0 +1,146 @@
+/// Routines to recycle thread control blocks and execution stacks.
+///
+/// Idle items are kept in singly linked free lists threaded through the
+/// items themselves, so the pool needs no memory of its own.
+///
+/// When a stack goes back to the pool, every page but the topmost one is
+/// returned to the host.  Idle stacks then cost a single page each, and the
+/// next thread to get the stack starts from a clean slate, which keeps the
+/// stack high-water mark reported by `Thread::GetStackHighWater` accurate.
+/// The link of an idle stack is stored in that top page.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_pool.hh"
+#include "thread.hh"
+
+#include <stdio.h>
+#include <new>
+
+
+/// Size in bytes of a pooled execution stack.
+static const unsigned STACK_BYTES = STACK_SIZE * sizeof (uintptr_t);
+
+/// Where the free list link of an idle stack is kept: its very top.
+static inline void *
+StackLink(uintptr_t *stack)
+{
+    return stack + STACK_SIZE - DivRoundUp(sizeof (void *),
+                                           sizeof (uintptr_t));
+}
+
+static inline uintptr_t *
+LinkStack(void *link)
+{
+    return (uintptr_t *) link - STACK_SIZE + DivRoundUp(sizeof (void *),
+                                                        sizeof (uintptr_t));
+}
+
+ThreadPool::ThreadPool(unsigned highWater_)
+{
+    highWater      = highWater_;
+    freeThreads    = nullptr;
+    numFreeThreads = 0;
+    freeStacks     = nullptr;
+    numFreeStacks  = 0;
+    threadHits = threadMisses = 0;
+    stackHits  = stackMisses  = 0;
+
+    for (unsigned i = 0; i < highWater; i++) {
+        PutThread(::operator new(sizeof (Thread)));
+        PutStack((uintptr_t *) SystemDep::AllocGuardedArray(STACK_BYTES));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    DEBUG('t', "Thread pool: threads %lu reused, %lu allocated; "
+               "stacks %lu reused, %lu allocated\n",
+          threadHits, threadMisses, stackHits, stackMisses);
+
+    while (freeThreads != nullptr) {
+        FreeItem *item = freeThreads;
+        freeThreads = item->next;
+        ::operator delete(item);
+    }
+    while (freeStacks != nullptr) {
+        FreeItem *item = freeStacks;
+        freeStacks = item->next;
+        SystemDep::DeallocGuardedArray((char *) LinkStack(item),
+                                       STACK_BYTES);
+    }
+}
+
+void *
+ThreadPool::GetThread()
+{
+    if (freeThreads == nullptr) {
+        threadMisses++;
+        return ::operator new(sizeof (Thread));
+    }
+    threadHits++;
+    FreeItem *item = freeThreads;
+    freeThreads = item->next;
+    numFreeThreads--;
+    return item;
+}
+
+void
+ThreadPool::PutThread(void *p)
+{
+    ASSERT(p != nullptr);
+
+    if (numFreeThreads >= highWater) {
+        ::operator delete(p);
+        return;
+    }
+    FreeItem *item = new (p) FreeItem;
+    item->next = freeThreads;
+    freeThreads = item;
+    numFreeThreads++;
+}
+
+uintptr_t *
+ThreadPool::GetStack()
+{
+    if (freeStacks == nullptr) {
+        stackMisses++;
+        return (uintptr_t *) SystemDep::AllocGuardedArray(STACK_BYTES);
+    }
+    stackHits++;
+    FreeItem *item = freeStacks;
+    freeStacks = item->next;
+    numFreeStacks--;
+    return LinkStack(item);
+}
+
+void
+ThreadPool::PutStack(uintptr_t *stack)
+{
+    ASSERT(stack != nullptr);
+
+    if (numFreeStacks >= highWater) {
+        SystemDep::DeallocGuardedArray((char *) stack, STACK_BYTES);
+        return;
+    }
+    // Keep the top page, which holds the link.
+    SystemDep::DiscardArray((char *) stack, STACK_BYTES - 1);
+    FreeItem *item = new (StackLink(stack)) FreeItem;
+    item->next = freeStacks;
+    freeStacks = item;
+    numFreeStacks++;
+}
+
+void
+ThreadPool::Print() const
+{
+    printf("Thread pool: high water %u, idle threads %u, idle stacks %u\n",
+           highWater, numFreeThreads, numFreeStacks);
+    printf("    threads: %lu reused, %lu allocated\n",
+           threadHits, threadMisses);
+    printf("    stacks: %lu reused, %lu allocated\n",
+           stackHits, stackMisses);
+}
@@ -0,0 +1,80 @@
+/// A pool of thread control blocks and execution stacks.
+///
+/// Every `Thread::Fork` needs an execution stack, and every finished thread
+/// is destroyed by `Scheduler::Run` once another thread is running.  Without
+/// a pool, workloads that create many short-lived threads (for instance, a
+/// shell calling `Exec` in a loop) go to the host allocator twice per
+/// thread, and map and unmap a guarded stack each time.
+///
+/// Instead, finished threads hand their stack and their `Thread` storage
+/// back to the pool, and new threads take them from it.  The pool keeps at
+/// most `highWater` idle items of each kind; anything beyond that is given
+/// back to the host.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_THREADPOOL__HH
+#define NACHOS_THREADS_THREADPOOL__HH
+
+
+#include <stddef.h>
+#include <stdint.h>
+
+
+/// Default number of idle stacks and thread control blocks to keep.
+const unsigned DEFAULT_THREAD_POOL_HIGH_WATER = 16;
+
+class ThreadPool {
+public:
+
+    /// Initialize the pool, pre-allocating `highWater` stacks and thread
+    /// control blocks.
+    ///
+    /// * `highWater` is the maximum number of idle items of each kind kept
+    ///   by the pool.  Zero disables pooling altogether.
+    ThreadPool(unsigned highWater);
+
+    /// Give every idle item back to the host.
+    ~ThreadPool();
+
+    /// Get storage for a `Thread` object.
+    void *GetThread();
+
+    /// Return storage obtained through `GetThread`.
+    void PutThread(void *p);
+
+    /// Get an execution stack of `STACK_SIZE` words.
+    ///
+    /// The stack is preceded by a guard page, so overflowing it faults.
+    uintptr_t *GetStack();
+
+    /// Return a stack obtained through `GetStack`.
+    void PutStack(uintptr_t *stack);
+
+    /// Print pool usage.
+    void Print() const;
+
+private:
+
+    /// An idle item; its storage is reused as the link to the next one.
+    struct FreeItem {
+        FreeItem *next;
+    };
+
+    unsigned highWater;
+
+    FreeItem *freeThreads;
+    unsigned numFreeThreads;
+
+    FreeItem *freeStacks;
+    unsigned numFreeStacks;
+
+    /// Usage counters.
+    unsigned long threadHits, threadMisses;
+    unsigned long stackHits, stackMisses;
+};
+
+
+#endif
@@ -11,13 +11,22 @@
 /// limitation of liability and disclaimer of warranty provisions.
 
 
+#include "thread_test_barrier.hh"
+#include "thread_test_broadcast.hh"
+#include "thread_test_buffered_channel.hh"
 #include "thread_test_garden.hh"
 #include "thread_test_garden_sem.hh"
 #include "thread_test_prod_cons.hh"
+#include "thread_test_rw_lock.hh"
 #include "thread_test_simple.hh"
+#include "thread_test_sleep.hh"
 #include "thread_test_channel.hh"
 #include "thread_test_join.hh"
+#include "thread_test_lock_dep.hh"
 #include "thread_test_priority.hh"
+#include "thread_test_priority_chain.hh"
+#include "thread_test_stack.hh"
+#include "thread_test_wait_queue.hh"
 
 
 #include "lib/utility.hh"
@@ -40,7 +49,21 @@ static const Test TESTS[] = {
     { &ThreadTestChannel, "channel", "Channel test"},
     { &ThreadTestJoin, "join", "Thread Join test"},
     { &ThreadTestPriority, "Priority", "Thread Priority test"},
-    { &ThreadTestGardenSem, "garden sem", "Ornamental garden with semaphores"}
+    { &ThreadTestGardenSem, "garden sem", "Ornamental garden with semaphores"},
+    { &ThreadTestStack, "stack", "Per-thread stack sizes"},
+    { &ThreadTestPriorityChain, "priority chain",
+      "Priority inheritance through lock chains"},
+    { &ThreadTestWaitQueue, "wait queue",
+      "Priority-ordered wakeup in synchronization primitives"},
+    { &ThreadTestRWLock, "rwlock", "Reader-writer lock stress test"},
+    { &ThreadTestBufferedChannel, "buffered channel",
+      "Bounded buffered channel pipeline"},
+    { &ThreadTestBarrier, "barrier", "Barriers and count-down latches"},
+    { &ThreadTestSleep, "sleep", "Sleep queue and timed waits"},
+    { &ThreadTestLockDep, "lockdep",
+      "Lock order validation (run with `-do lockdep`)"},
+    { &ThreadTestBroadcast, "broadcast",
+      "Condition broadcast hands the lock to waiters one at a time"}
 };
 static const unsigned NUM_TESTS = sizeof TESTS / sizeof TESTS[0];
 
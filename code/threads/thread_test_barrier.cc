@@ -0,0 +1,84 @@
+/// Barrier and latch test.
+///
+/// Workers go through several phases separated by a barrier, each doing a
+/// different amount of work per phase, and check that nobody gets ahead.
+/// The main thread holds them at a start latch and waits for all of them
+/// on a done latch.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_barrier.hh"
+#include "system.hh"
+#include "barrier.hh"
+#include "count_down_latch.hh"
+
+#include <stdio.h>
+
+
+static const unsigned NUM_WORKERS = 5;
+static const unsigned NUM_PHASES = 4;
+
+static Barrier *barrier;
+static CountDownLatch *start;
+static CountDownLatch *done;
+
+static bool finished[NUM_PHASES][NUM_WORKERS];
+static unsigned lastArrivals[NUM_PHASES];
+
+static void
+Worker(void *n_)
+{
+    unsigned n = *(unsigned *) n_;
+
+    start->Wait();
+    for (unsigned phase = 0; phase < NUM_PHASES; phase++) {
+        for (unsigned i = 0; i < (n + phase) % 3; i++) {
+            currentThread->Yield();
+        }
+        finished[phase][n] = true;
+
+        if (barrier->Wait()) {
+            lastArrivals[phase]++;
+        }
+        ASSERT(barrier->GetGeneration() >= phase + 1);
+        for (unsigned i = 0; i < NUM_WORKERS; i++) {
+            ASSERT(finished[phase][i]);
+        }
+    }
+    done->CountDown();
+}
+
+void
+ThreadTestBarrier()
+{
+    barrier = new Barrier("phases", NUM_WORKERS);
+    start = new CountDownLatch("start", 1);
+    done = new CountDownLatch("done", NUM_WORKERS);
+
+    static unsigned ids[NUM_WORKERS];
+    for (unsigned i = 0; i < NUM_WORKERS; i++) {
+        ids[i] = i;
+        Thread *t = new Thread("worker");
+        t->Fork(Worker, &ids[i]);
+    }
+
+    // Let every worker reach the start line.
+    currentThread->Yield();
+    start->CountDown();
+    done->Wait();
+
+    ASSERT(barrier->GetGeneration() == NUM_PHASES);
+    for (unsigned phase = 0; phase < NUM_PHASES; phase++) {
+        ASSERT(lastArrivals[phase] == 1);
+    }
+    barrier->Print();
+    done->Print();
+
+    delete done;
+    delete start;
+    delete barrier;
+    printf("Test finished\n");
+}
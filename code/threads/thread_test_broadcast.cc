@@ -0,0 +1,82 @@
+/// Condition variable broadcast test.
+///
+/// Several waiters block on a condition, and the main thread broadcasts it
+/// while holding the lock.  Waiters must be moved to the lock instead of
+/// being made ready, so each of them comes back from `Wait` after blocking
+/// only once, holding the lock, and alone inside the critical section.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_broadcast.hh"
+#include "system.hh"
+#include "condition.hh"
+
+#include <stdio.h>
+
+
+static const unsigned NUM_WAITERS = 6;
+
+static Lock *lock;
+static Condition *go;
+static bool started;
+static unsigned waiting;
+static unsigned inside;
+static unsigned woken;
+
+static void
+Waiter(void *)
+{
+    lock->Acquire();
+    waiting++;
+    while (!started) {
+        unsigned long before = currentThread->GetSwitches(true);
+        go->Wait();
+        ASSERT(lock->IsHeldByCurrentThread());
+        ASSERT(currentThread->GetSwitches(true) == before + 1);
+    }
+    inside++;
+    ASSERT(inside == 1);
+    currentThread->Yield();
+    inside--;
+    woken++;
+    lock->Release();
+}
+
+void
+ThreadTestBroadcast()
+{
+    lock = new Lock("broadcast lock");
+    go = new Condition("broadcast go", lock);
+    started = false;
+    waiting = inside = woken = 0;
+
+    Thread *waiters[NUM_WAITERS];
+    for (unsigned i = 0; i < NUM_WAITERS; i++) {
+        waiters[i] = new Thread("waiter", true);
+        waiters[i]->Fork(Waiter, nullptr);
+    }
+
+    // Waiters count themselves before waiting, and waiting releases the
+    // lock, so once the lock is free and all are counted, all are waiting.
+    lock->Acquire();
+    while (waiting < NUM_WAITERS) {
+        lock->Release();
+        currentThread->Yield();
+        lock->Acquire();
+    }
+    started = true;
+    go->Broadcast();
+    lock->Release();
+
+    for (unsigned i = 0; i < NUM_WAITERS; i++) {
+        waiters[i]->Join();
+    }
+    ASSERT(woken == NUM_WAITERS);
+
+    delete go;
+    delete lock;
+    printf("Test finished\n");
+}
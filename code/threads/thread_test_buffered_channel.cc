@@ -0,0 +1,156 @@
+/// Buffered channel test.
+///
+/// A three-stage pipeline: a producer sends numbered messages in batches, a
+/// filter doubles their values, and two consumers add them up.  Each stage
+/// moves several messages per channel operation whenever it can.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_buffered_channel.hh"
+#include "system.hh"
+#include "buffered_channel.hh"
+
+#include <stdio.h>
+
+
+struct Message {
+    unsigned seq;
+    int value;
+};
+
+static const unsigned NUM_MESSAGES = 1000;
+static const unsigned BATCH = 7;
+static const unsigned NUM_CONSUMERS = 2;
+
+/// Sequence number marking the end of the stream.
+static const unsigned END = 0;
+
+static BufferedChannel<Message> *raw;
+static BufferedChannel<Message> *doubled;
+
+static long sums[NUM_CONSUMERS];
+static unsigned batches[NUM_CONSUMERS];
+
+static void
+Producer(void *)
+{
+    Message batch[BATCH];
+    for (unsigned seq = 1; seq <= NUM_MESSAGES; ) {
+        unsigned n = 0;
+        for (; n < BATCH && seq <= NUM_MESSAGES; n++, seq++) {
+            batch[n].seq = seq;
+            batch[n].value = seq;
+        }
+        raw->SendMany(batch, n);
+    }
+    Message end = { END, 0 };
+    raw->Send(end);
+}
+
+static void
+Filter(void *)
+{
+    Message batch[BATCH];
+    unsigned expected = 1;
+    for (;;) {
+        unsigned n = raw->ReceiveMany(batch, BATCH);
+        for (unsigned i = 0; i < n; i++) {
+            if (batch[i].seq == END) {
+                ASSERT(i == n - 1);
+                doubled->SendMany(batch, n - 1);
+                for (unsigned j = 0; j < NUM_CONSUMERS; j++) {
+                    doubled->Send(batch[i]);
+                }
+                return;
+            }
+            ASSERT(batch[i].seq == expected++);
+            batch[i].value *= 2;
+        }
+        doubled->SendMany(batch, n);
+    }
+}
+
+static void
+Consumer(void *n_)
+{
+    unsigned n = *(unsigned *) n_;
+    Message batch[BATCH];
+    unsigned lastSeq = 0;
+    for (;;) {
+        unsigned count = doubled->ReceiveMany(batch, BATCH);
+        batches[n]++;
+        for (unsigned i = 0; i < count; i++) {
+            if (batch[i].seq == END) {
+                // Whatever follows belongs to the other consumer.
+                doubled->SendMany(&batch[i + 1], count - i - 1);
+                return;
+            }
+            ASSERT(batch[i].seq > lastSeq);
+            lastSeq = batch[i].seq;
+            sums[n] += batch[i].value;
+        }
+    }
+}
+
+/// Non-blocking operations on a channel nobody else uses.
+static void
+TestTry()
+{
+    BufferedChannel<int> *channel = new BufferedChannel<int>("try", 4);
+    int item;
+    int items[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+
+    ASSERT(!channel->TryReceive(&item));
+    ASSERT(channel->TrySend(0));
+    ASSERT(channel->TrySendMany(items, 8) == 3);
+    ASSERT(!channel->TrySend(9));
+    ASSERT(channel->Count() == channel->GetCapacity());
+
+    ASSERT(channel->TryReceive(&item) && item == 0);
+    ASSERT(channel->TryReceiveMany(items, 8) == 3);
+    ASSERT(items[0] == 1 && items[1] == 2 && items[2] == 3);
+    ASSERT(channel->TryReceiveMany(items, 8) == 0);
+
+    delete channel;
+}
+
+void
+ThreadTestBufferedChannel()
+{
+    TestTry();
+
+    raw = new BufferedChannel<Message>("raw", 16);
+    doubled = new BufferedChannel<Message>("doubled", 4);
+
+    Thread *producer = new Thread("producer", true);
+    Thread *filter = new Thread("filter", true);
+    producer->Fork(Producer, nullptr);
+    filter->Fork(Filter, nullptr);
+
+    static unsigned ids[NUM_CONSUMERS];
+    Thread *consumers[NUM_CONSUMERS];
+    for (unsigned i = 0; i < NUM_CONSUMERS; i++) {
+        ids[i] = i;
+        consumers[i] = new Thread("consumer", true);
+        consumers[i]->Fork(Consumer, &ids[i]);
+    }
+
+    producer->Join();
+    filter->Join();
+    long total = 0;
+    for (unsigned i = 0; i < NUM_CONSUMERS; i++) {
+        consumers[i]->Join();
+        printf("*** Consumer %u: sum %ld in %u receives\n",
+               i, sums[i], batches[i]);
+        total += sums[i];
+    }
+    ASSERT(total == (long) NUM_MESSAGES * (NUM_MESSAGES + 1));
+    ASSERT(raw->Count() == 0 && doubled->Count() == 0);
+
+    delete doubled;
+    delete raw;
+    printf("Test finished\n");
+}
@@ -8,13 +8,14 @@
 #include "thread_test_garden_sem.hh"
 #include "system.hh"
 #include "semaphore.hh"
+#include "count_down_latch.hh"
 
 #include <stdio.h>
 
 
 static const unsigned NUM_TURNSTILES = 2;
 static const unsigned ITERATIONS_PER_TURNSTILE = 50;
-static bool done[NUM_TURNSTILES];
+static CountDownLatch *done;
 static int count;
 
 static Semaphore * semaphore = new Semaphore("testGardenSem", 1);
@@ -36,7 +37,7 @@ Turnstile(void *n_)
         currentThread->Yield();
     }
     printf("Turnstile %u finished. Count is now %u.\n", *n, count);
-    done[*n] = true;
+    done->CountDown();
 }
 
 void
@@ -45,6 +46,7 @@ ThreadTestGardenSem()
     //Launch a new thread for each turnstile 
     //(except one that will be run by the main thread)
 
+    done = new CountDownLatch("garden sem done", NUM_TURNSTILES);
     char **names = new char*[NUM_TURNSTILES];
     unsigned *values = new unsigned[NUM_TURNSTILES];
     for (unsigned i = 0; i < NUM_TURNSTILES; i++) {
@@ -57,14 +59,9 @@ ThreadTestGardenSem()
         t->Fork(Turnstile, (void *) &(values[i]));
     }
    
-    // Wait until all turnstile threads finish their work.  `Thread::Join` is
-    // not implemented at the beginning, therefore an ad-hoc workaround is
-    // applied here.
-    for (unsigned i = 0; i < NUM_TURNSTILES; i++) {
-        while (!done[i]) {
-            currentThread->Yield();
-        }
-    }
+    // Wait until all turnstile threads finish their work.
+    done->Wait();
+    delete done;
 
     printf("All turnstiles finished. Final count is %u (should be %u).\n",
            count, ITERATIONS_PER_TURNSTILE * NUM_TURNSTILES);
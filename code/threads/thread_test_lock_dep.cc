@@ -0,0 +1,69 @@
+/// Lock order validation.
+///
+/// `first` takes `a` then `b`; once it is done, `second` takes `b` then
+/// `a`.  The threads never overlap, so the run cannot hang, but had they
+/// overlapped they could have deadlocked, and the validator must say so.
+/// Taking the locks again in the first order must not report anything new.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_test_lock_dep.hh"
+#include "system.hh"
+#include "lock.hh"
+
+#include <stdio.h>
+
+
+static Lock *a;
+static Lock *b;
+
+static void
+InOrder(void *)
+{
+    a->Acquire();
+    b->Acquire();
+    b->Release();
+    a->Release();
+}
+
+static void
+Reversed(void *)
+{
+    b->Acquire();
+    a->Acquire();
+    a->Release();
+    b->Release();
+}
+
+static void
+Run(const char *name, VoidFunctionPtr func)
+{
+    Thread *t = new Thread(name, true);
+    t->Fork(func, nullptr);
+    t->Join();
+}
+
+void
+ThreadTestLockDep()
+{
+    if (lockDep == nullptr) {
+        printf("Lock order validation is off; run with `-do lockdep`\n");
+    }
+    unsigned before = lockDep != nullptr ? lockDep->GetNumCycles() : 0;
+
+    a = new Lock("lockdep a");
+    b = new Lock("lockdep b");
+
+    Run("first", InOrder);
+    Run("second", Reversed);
+    Run("third", InOrder);
+
+    if (lockDep != nullptr) {
+        ASSERT(lockDep->GetNumCycles() == before + 1);
+    }
+    delete a;
+    delete b;
+    printf("Test finished\n");
+}
@@ -0,0 +1,126 @@
+/// Priority inheritance through a chain of locks.
+///
+/// `C` (priority 1) holds `l2`; `B` (priority 3) holds `l1` and waits for
+/// `l2`; then `A` (priority 8) waits for `l1`.  A's priority must flow
+/// through B down to C, so that neither the main thread nor `M` (priority
+/// 5) can delay A.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_test_priority_chain.hh"
+#include "system.hh"
+#include "lock.hh"
+#include "semaphore.hh"
+
+#include <stdio.h>
+#include <string.h>
+
+
+static Lock *l1;
+static Lock *l2;
+static Semaphore *started;
+static bool aWaiting;
+
+static const unsigned MAX_EVENTS = 8;
+static const char *events[MAX_EVENTS];
+static unsigned numEvents;
+
+static void
+Record(const char *event)
+{
+    ASSERT(numEvents < MAX_EVENTS);
+    printf("*** Thread `%s` (priority %u): %s\n",
+           currentThread->GetName(), currentThread->GetPriority(), event);
+    events[numEvents++] = event;
+}
+
+static void
+ThreadC(void *)
+{
+    l2->Acquire();
+    started->V();
+    while (!aWaiting) {
+        currentThread->Yield();
+    }
+    ASSERT(currentThread->GetPriority() == 8);
+    Record("C releases l2");
+    l2->Release();
+    ASSERT(currentThread->GetPriority() == 1);
+}
+
+static void
+ThreadB(void *)
+{
+    l1->Acquire();
+    started->V();
+    l2->Acquire();
+    ASSERT(currentThread->GetPriority() == 8);
+    Record("B got l2");
+    l2->Release();
+    // A is still waiting for `l1`.
+    ASSERT(currentThread->GetPriority() == 8);
+    l1->Release();
+    ASSERT(currentThread->GetPriority() == 3);
+}
+
+static void
+ThreadA(void *)
+{
+    started->V();
+    aWaiting = true;
+    l1->Acquire();
+    Record("A got l1");
+    l1->Release();
+}
+
+static void
+ThreadM(void *)
+{
+    Record("M runs");
+}
+
+void
+ThreadTestPriorityChain()
+{
+    l1 = new Lock("l1");
+    l2 = new Lock("l2");
+    started = new Semaphore("started", 0);
+    aWaiting = false;
+    numEvents = 0;
+
+    Thread *c = new Thread("C", true, 1);
+    c->Fork(ThreadC, nullptr);
+    started->P();
+
+    Thread *b = new Thread("B", true, 3);
+    b->Fork(ThreadB, nullptr);
+    started->P();
+
+    // A goes first: were the main thread switched out in between, `M`
+    // would otherwise run before A even exists.
+    Thread *a = new Thread("A", true, 8);
+    a->Fork(ThreadA, nullptr);
+    Thread *m = new Thread("M", true, 5);
+    m->Fork(ThreadM, nullptr);
+    started->P();
+
+    a->Join();
+    b->Join();
+    c->Join();
+    m->Join();
+
+    static const char *EXPECTED[] = {
+        "C releases l2", "B got l2", "A got l1", "M runs"
+    };
+    ASSERT(numEvents == sizeof EXPECTED / sizeof EXPECTED[0]);
+    for (unsigned i = 0; i < numEvents; i++) {
+        ASSERT(strcmp(events[i], EXPECTED[i]) == 0);
+    }
+    printf("Test finished\n");
+
+    delete started;
+    delete l2;
+    delete l1;
+}
@@ -8,6 +8,7 @@
 #include "thread_test_prod_cons.hh"
 #include "system.hh"
 #include "condition.hh"
+#include "semaphore.hh"
 
 #include <stdio.h>
 
@@ -0,0 +1,157 @@
+/// Stress test for reader-writer locks.
+///
+/// Writers fill a shared record with their own value one field at a time,
+/// yielding in between; readers check that every field holds the same
+/// value, also yielding in between.  A reader seeing a torn record, or a
+/// writer overlapping anyone else, means the lock failed.  Some readers
+/// upgrade to write and some writers downgrade to read.
+///
+/// The test runs once for each reader/writer preference.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_rw_lock.hh"
+#include "system.hh"
+#include "rw_lock.hh"
+
+#include <stdio.h>
+
+
+static const unsigned NUM_READERS = 6;
+static const unsigned NUM_WRITERS = 3;
+static const unsigned ITERATIONS = 20;
+static const unsigned RECORD_SIZE = 4;
+
+static RWLock *rwLock;
+static int record[RECORD_SIZE];
+
+static unsigned activeReaders, activeWriters;
+static unsigned maxActiveReaders;
+
+static void
+EnterRead()
+{
+    ASSERT(activeWriters == 0);
+    if (++activeReaders > maxActiveReaders) {
+        maxActiveReaders = activeReaders;
+    }
+}
+
+static void
+EnterWrite()
+{
+    ASSERT(activeWriters == 0 && activeReaders == 0);
+    activeWriters++;
+}
+
+static void
+CheckRecord()
+{
+    for (unsigned i = 1; i < RECORD_SIZE; i++) {
+        ASSERT(record[i] == record[0]);
+        currentThread->Yield();
+    }
+}
+
+static void
+FillRecord(int value)
+{
+    for (unsigned i = 0; i < RECORD_SIZE; i++) {
+        record[i] = value;
+        currentThread->Yield();
+    }
+}
+
+static void
+Reader(void *n_)
+{
+    unsigned n = *(unsigned *) n_;
+
+    for (unsigned i = 0; i < ITERATIONS; i++) {
+        rwLock->AcquireRead();
+        EnterRead();
+        CheckRecord();
+
+        if (n % 3 == 0 && i % 5 == 0) {
+            // Fix the record up in place.
+            activeReaders--;
+            if (!rwLock->Upgrade()) {
+                rwLock->ReleaseRead();
+                rwLock->AcquireWrite();
+            }
+            EnterWrite();
+            FillRecord(-(int) n);
+            activeWriters--;
+            rwLock->ReleaseWrite();
+        } else {
+            activeReaders--;
+            rwLock->ReleaseRead();
+        }
+        currentThread->Yield();
+    }
+}
+
+static void
+Writer(void *n_)
+{
+    unsigned n = *(unsigned *) n_;
+
+    for (unsigned i = 0; i < ITERATIONS; i++) {
+        rwLock->AcquireWrite();
+        EnterWrite();
+        FillRecord(n * ITERATIONS + i);
+
+        if (i % 4 == 0) {
+            // Keep reading what we just wrote.
+            activeWriters--;
+            rwLock->Downgrade();
+            EnterRead();
+            CheckRecord();
+            activeReaders--;
+            rwLock->ReleaseRead();
+        } else {
+            activeWriters--;
+            rwLock->ReleaseWrite();
+        }
+        currentThread->Yield();
+    }
+}
+
+static void
+Run(RWPreference preference, const char *description)
+{
+    rwLock = new RWLock(description, preference);
+    activeReaders = activeWriters = maxActiveReaders = 0;
+
+    static unsigned ids[NUM_READERS + NUM_WRITERS];
+    Thread *threads[NUM_READERS + NUM_WRITERS];
+    for (unsigned i = 0; i < NUM_READERS + NUM_WRITERS; i++) {
+        ids[i] = i;
+        bool isReader = i % 3 != 2;
+        threads[i] = new Thread(isReader ? "reader" : "writer", true);
+        threads[i]->Fork(isReader ? Reader : Writer, &ids[i]);
+    }
+    for (unsigned i = 0; i < NUM_READERS + NUM_WRITERS; i++) {
+        threads[i]->Join();
+    }
+
+    ASSERT(activeReaders == 0 && activeWriters == 0);
+    // Readers must have shared the lock at some point.
+    ASSERT(maxActiveReaders > 1);
+    printf("*** %s: up to %u concurrent readers\n",
+           description, maxActiveReaders);
+    rwLock->Print();
+    delete rwLock;
+}
+
+void
+ThreadTestRWLock()
+{
+    Run(RW_PREFER_READERS, "prefer readers");
+    Run(RW_PREFER_WRITERS, "prefer writers");
+    Run(RW_FAIR, "fair");
+    printf("Test finished\n");
+}
@@ -0,0 +1,134 @@
+/// Sleep queue and timed wait test.
+///
+/// Threads sleeping for different times must wake up in order and no
+/// earlier than asked; timed waits must return early when the semaphore or
+/// condition is signalled, and fail once the time runs out.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_sleep.hh"
+#include "system.hh"
+#include "condition.hh"
+#include "semaphore.hh"
+
+#include <stdio.h>
+
+
+static const unsigned NUM_SLEEPERS = 4;
+static const unsigned long NAPS[NUM_SLEEPERS] = { 300, 100, 400, 200 };
+
+static unsigned long wakeTimes[NUM_SLEEPERS];
+static unsigned order[NUM_SLEEPERS];
+static unsigned numAwake;
+
+static Semaphore *sem;
+static Lock *lock;
+static Condition *cond;
+
+static void
+SleepingThread(void *n_)
+{
+    unsigned n = *(unsigned *) n_;
+    unsigned long start = stats->totalTicks;
+
+    currentThread->SleepFor(NAPS[n]);
+    wakeTimes[n] = stats->totalTicks - start;
+    order[numAwake++] = n;
+}
+
+static void
+LateV(void *)
+{
+    currentThread->SleepFor(50);
+    sem->V();
+}
+
+static void
+LateSignal(void *)
+{
+    currentThread->SleepFor(50);
+    lock->Acquire();
+    cond->Signal();
+    lock->Release();
+}
+
+static void
+TestSleepFor()
+{
+    static unsigned ids[NUM_SLEEPERS];
+    Thread *threads[NUM_SLEEPERS];
+    for (unsigned i = 0; i < NUM_SLEEPERS; i++) {
+        ids[i] = i;
+        threads[i] = new Thread("sleeper", true);
+        threads[i]->Fork(SleepingThread, &ids[i]);
+    }
+    for (unsigned i = 0; i < NUM_SLEEPERS; i++) {
+        threads[i]->Join();
+    }
+
+    ASSERT(numAwake == NUM_SLEEPERS);
+    for (unsigned i = 0; i < NUM_SLEEPERS; i++) {
+        ASSERT(wakeTimes[i] >= NAPS[i]);
+        if (i > 0) {
+            ASSERT(NAPS[order[i - 1]] < NAPS[order[i]]);
+        }
+        printf("*** Sleeper %u asked for %lu ticks, slept %lu\n",
+               i, NAPS[i], wakeTimes[i]);
+    }
+}
+
+static void
+TestTimedP()
+{
+    unsigned long start = stats->totalTicks;
+    ASSERT(!sem->TimedP(100));
+    ASSERT(stats->totalTicks - start >= 100);
+
+    Thread *t = new Thread("late V", true);
+    t->Fork(LateV, nullptr);
+    start = stats->totalTicks;
+    ASSERT(sem->TimedP(1000));
+    ASSERT(stats->totalTicks - start < 1000);
+    t->Join();
+    printf("*** TimedP ok\n");
+}
+
+static void
+TestTimedWait()
+{
+    lock->Acquire();
+    unsigned long start = stats->totalTicks;
+    ASSERT(!cond->TimedWait(100));
+    ASSERT(lock->IsHeldByCurrentThread());
+    ASSERT(stats->totalTicks - start >= 100);
+
+    Thread *t = new Thread("late signal", true);
+    t->Fork(LateSignal, nullptr);
+    start = stats->totalTicks;
+    ASSERT(cond->TimedWait(1000));
+    ASSERT(stats->totalTicks - start < 1000);
+    lock->Release();
+    t->Join();
+    printf("*** TimedWait ok\n");
+}
+
+void
+ThreadTestSleep()
+{
+    sem = new Semaphore("sleep test", 0);
+    lock = new Lock("sleep test");
+    cond = new Condition("sleep test", lock);
+
+    TestSleepFor();
+    TestTimedP();
+    TestTimedWait();
+    ASSERT(sleepQueue->IsEmpty());
+
+    delete cond;
+    delete lock;
+    delete sem;
+    printf("Test finished\n");
+}
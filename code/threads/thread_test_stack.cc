@@ -0,0 +1,92 @@
+/// Copyright (c) 1992-1993 The Regents of the University of California.
+///               2007-2009 Universidad de Las Palmas de Gran Canaria.
+///               2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "thread_test_stack.hh"
+#include "system.hh"
+#include "semaphore.hh"
+
+#include <stdio.h>
+
+
+/// Many tiny helper threads, alive at the same time.
+static const unsigned NUM_TINY = 2000;
+
+/// One thread with a deep call chain, on a large lazily committed stack.
+static const unsigned DEEP_STACK_SIZE = 256 * 1024;
+static const unsigned DEEP_LEVELS = 2000;
+
+static unsigned tinyHighWater[NUM_TINY];
+static unsigned deepHighWater;
+static Semaphore *done;
+
+static void
+Tiny(void *n_)
+{
+    unsigned *n = (unsigned *) n_;
+
+    // Make sure every tiny thread is alive at once.
+    currentThread->Yield();
+    tinyHighWater[*n] = currentThread->GetStackHighWater();
+    done->V();
+}
+
+static unsigned
+Recurse(unsigned level)
+{
+    volatile char frame[128];
+    frame[0] = (char) level;
+    if (level == 0) {
+        deepHighWater = currentThread->GetStackHighWater();
+        return frame[0];
+    }
+    return Recurse(level - 1) + frame[0];
+}
+
+static void
+Deep(void *)
+{
+    Recurse(DEEP_LEVELS);
+    done->V();
+}
+
+void
+ThreadTestStack()
+{
+    done = new Semaphore("stack test done", 0);
+
+    unsigned *ids = new unsigned [NUM_TINY];
+    for (unsigned i = 0; i < NUM_TINY; i++) {
+        ids[i] = i;
+        Thread *t = new Thread("tiny", 0, 4, MIN_STACK_SIZE);
+        t->Fork(Tiny, &ids[i]);
+    }
+    Thread *deep = new Thread("deep", 0, 4, DEEP_STACK_SIZE);
+    deep->Fork(Deep, nullptr);
+
+    for (unsigned i = 0; i < NUM_TINY + 1; i++) {
+        done->P();
+    }
+
+    unsigned maxTiny = 0;
+    for (unsigned i = 0; i < NUM_TINY; i++) {
+        ASSERT(tinyHighWater[i] > 0);
+        if (tinyHighWater[i] > maxTiny) {
+            maxTiny = tinyHighWater[i];
+        }
+    }
+    printf("%u tiny threads with %u-byte stacks used at most %u bytes.\n",
+           NUM_TINY, MIN_STACK_SIZE * (unsigned) sizeof (uintptr_t), maxTiny);
+    printf("Deep thread with a %u-byte stack used %u bytes for %u levels.\n",
+           DEEP_STACK_SIZE * (unsigned) sizeof (uintptr_t), deepHighWater,
+           DEEP_LEVELS);
+    ASSERT(deepHighWater >= DEEP_LEVELS * 128);
+    ASSERT(deepHighWater < DEEP_STACK_SIZE * sizeof (uintptr_t));
+
+    delete [] ids;
+    delete done;
+    printf("Test finished\n");
+}
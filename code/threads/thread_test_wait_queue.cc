@@ -0,0 +1,134 @@
+/// Wakeup order of threads blocked on semaphores, locks and condition
+/// variables.
+///
+/// Three threads block on the same primitive in increasing priority order,
+/// so a FIFO queue would wake the lowest priority one first.  Once woken,
+/// each thread passes the primitive on to the next waiter, so the order in
+/// which they run is the order in which the queue woke them.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#include "thread_test_wait_queue.hh"
+#include "system.hh"
+#include "condition.hh"
+#include "semaphore.hh"
+
+#include <stdio.h>
+
+
+enum Primitive {
+    USE_SEMAPHORE,
+    USE_LOCK,
+    USE_CONDITION
+};
+
+static const unsigned NUM_WAITERS = 3;
+static const unsigned PRIORITIES[NUM_WAITERS] = { 1, 5, 7 };
+
+static Primitive primitive;
+static Semaphore *sem;
+static Lock *lock;
+static Condition *cond;
+static Semaphore *started;
+
+static unsigned order[NUM_WAITERS];
+static unsigned numWoken;
+
+static void
+Waiter(void *)
+{
+    switch (primitive) {
+        case USE_SEMAPHORE:
+            started->V();
+            sem->P();
+            order[numWoken++] = currentThread->GetOriginalPriority();
+            sem->V();
+            break;
+
+        case USE_LOCK:
+            started->V();
+            lock->Acquire();
+            order[numWoken++] = currentThread->GetOriginalPriority();
+            lock->Release();
+            break;
+
+        case USE_CONDITION:
+            lock->Acquire();
+            started->V();
+            cond->Wait();
+            order[numWoken++] = currentThread->GetOriginalPriority();
+            cond->Signal();
+            lock->Release();
+            break;
+    }
+}
+
+static void
+Run(Primitive p, const char *description)
+{
+    primitive = p;
+    numWoken = 0;
+    if (p == USE_LOCK) {
+        lock->Acquire();
+    }
+
+    Thread *threads[NUM_WAITERS];
+    for (unsigned i = 0; i < NUM_WAITERS; i++) {
+        threads[i] = new Thread("waiter", true, PRIORITIES[i]);
+        threads[i]->Fork(Waiter, nullptr);
+    }
+    for (unsigned i = 0; i < NUM_WAITERS; i++) {
+        started->P();
+    }
+
+    // Every waiter is blocked now; let the first one go.
+    switch (p) {
+        case USE_SEMAPHORE:
+            sem->V();
+            break;
+        case USE_LOCK:
+            lock->Release();
+            break;
+        case USE_CONDITION:
+            lock->Acquire();
+            cond->Signal();
+            lock->Release();
+            break;
+    }
+
+    for (unsigned i = 0; i < NUM_WAITERS; i++) {
+        threads[i]->Join();
+    }
+
+    printf("*** %s woke priorities", description);
+    for (unsigned i = 0; i < NUM_WAITERS; i++) {
+        printf(" %u", order[i]);
+    }
+    printf("\n");
+
+    ASSERT(numWoken == NUM_WAITERS);
+    for (unsigned i = 0; i < NUM_WAITERS; i++) {
+        ASSERT(order[i] == PRIORITIES[NUM_WAITERS - 1 - i]);
+    }
+}
+
+void
+ThreadTestWaitQueue()
+{
+    sem = new Semaphore("wait queue sem", 0);
+    lock = new Lock("wait queue lock");
+    cond = new Condition("wait queue cond", lock);
+    started = new Semaphore("wait queue started", 0);
+
+    Run(USE_SEMAPHORE, "Semaphore");
+    Run(USE_LOCK, "Lock");
+    Run(USE_CONDITION, "Condition");
+    printf("Test finished\n");
+
+    delete started;
+    delete cond;
+    delete lock;
+    delete sem;
+}
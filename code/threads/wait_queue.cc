@@ -0,0 +1,86 @@
+/// Routines to manage queues of waiting threads.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "wait_queue.hh"
+
+
+WaitQueue::WaitQueue(WaitPolicy policy_)
+{
+    policy  = policy_;
+    threads = new IntrusiveList<Thread, &Thread::queueLink>;
+}
+
+WaitQueue::~WaitQueue()
+{
+    delete threads;
+}
+
+WaitPolicy
+WaitQueue::GetPolicy() const
+{
+    return policy;
+}
+
+void
+WaitQueue::Append(Thread *thread)
+{
+    ASSERT(thread != nullptr);
+    threads->Append(thread);
+}
+
+/// `best_` points to the highest-priority thread seen so far.
+static void
+PickHighest(Thread *thread, void *best_)
+{
+    Thread **best = (Thread **) best_;
+    if (*best == nullptr || thread->GetPriority() > (*best)->GetPriority()) {
+        *best = thread;
+    }
+}
+
+Thread *
+WaitQueue::Pop()
+{
+    if (policy == WAIT_FIFO || threads->IsEmpty()) {
+        return threads->Pop();
+    }
+
+    Thread *best = nullptr;
+    threads->Apply(PickHighest, &best);
+    threads->Remove(best);
+    return best;
+}
+
+void
+WaitQueue::Remove(Thread *thread)
+{
+    ASSERT(Has(thread));
+    threads->Remove(thread);
+}
+
+bool
+WaitQueue::Has(Thread *thread) const
+{
+    return threads->Has(thread);
+}
+
+bool
+WaitQueue::IsEmpty() const
+{
+    return threads->IsEmpty();
+}
+
+unsigned
+WaitQueue::GetMaxPriority() const
+{
+    if (threads->IsEmpty()) {
+        return 0;
+    }
+    Thread *best = nullptr;
+    threads->Apply(PickHighest, &best);
+    return best->GetPriority();
+}
@@ -0,0 +1,70 @@
+/// Queues of threads blocked on a synchronization primitive.
+///
+/// `Semaphore`, `Lock` and `Condition` park their waiters in a `WaitQueue`.
+/// The queue's policy decides which waiter is woken first:
+///
+/// * `WAIT_FIFO`: the one that has waited the longest.
+/// * `WAIT_PRIORITY`: the one with the highest effective priority; among
+///   equals, the one that has waited the longest.
+///
+/// Effective priorities change while threads wait (a waiter may itself be
+/// holding a lock and receive a donation), so the queue is kept in arrival
+/// order and the choice is made when a thread is woken.
+///
+/// All operations assume that interrupts are disabled.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_THREADS_WAITQUEUE__HH
+#define NACHOS_THREADS_WAITQUEUE__HH
+
+
+#include "thread.hh"
+#include "lib/intrusive_list.hh"
+
+
+enum WaitPolicy {
+    WAIT_FIFO,
+    WAIT_PRIORITY
+};
+
+class WaitQueue {
+public:
+
+    WaitQueue(WaitPolicy policy = WAIT_PRIORITY);
+
+    ~WaitQueue();
+
+    WaitPolicy GetPolicy() const;
+
+    /// Add `thread` at the end of the queue.
+    void Append(Thread *thread);
+
+    /// Remove and return the next thread to wake up according to the
+    /// policy, or null if the queue is empty.
+    Thread *Pop();
+
+    /// Remove `thread`, which must be in the queue.
+    void Remove(Thread *thread);
+
+    bool Has(Thread *thread) const;
+
+    bool IsEmpty() const;
+
+    /// Highest priority among the waiting threads, or zero if there are
+    /// none.
+    unsigned GetMaxPriority() const;
+
+private:
+
+    WaitPolicy policy;
+
+    /// Waiting threads, in arrival order.
+    IntrusiveList<Thread, &Thread::queueLink> *threads;
+
+};
+
+
+#endif
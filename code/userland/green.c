@@ -0,0 +1,313 @@
+/// Green threads: cooperative user-level threads, multiplexed on a few
+/// kernel threads (workers).
+///
+/// Switching between green threads is a procedure call (`GreenSwitch`, in
+/// `green_switch.s`) instead of a `Yield` system call, which makes it much
+/// cheaper in the simulator.  Each worker has its own run queue, and runs
+/// the green threads bound to it; a thread is bound to a worker when it is
+/// spawned, and never migrates, so the queues need no locking.
+///
+/// Blocking I/O goes through `greenRead` and `greenWrite`.  A thread doing
+/// I/O lets the other ready threads of its worker run first, and the
+/// worker only calls into the kernel, on its behalf, once none of them can
+/// run.
+///
+/// Usage: include this file after `lib.c`, link the program with
+/// `green_switch.o`, then
+///
+///     greenInit(workers);
+///     greenSpawn(func, arg);  // As many times as needed.
+///     greenRun();             // Returns when every green thread is done.
+///
+/// Open files belong to the kernel thread that opened them, so with more
+/// than one worker, only the console can be used from every green thread.
+
+
+#define GREEN_MAX_THREADS    16
+#define GREEN_MAX_WORKERS    4
+#define GREEN_STACK_SIZE     1024  // Bytes.
+
+/// Saved registers: `s0`-`s7`, `gp`, `sp`, `fp` and `ra`.
+#define GREEN_CONTEXT_WORDS  12
+#define GREEN_CONTEXT_SP     9
+#define GREEN_CONTEXT_RA     11
+
+enum {
+    GREEN_FREE,
+    GREEN_READY,
+    GREEN_RUNNING,
+    GREEN_BLOCKED,  // Waiting for its worker to do some I/O.
+    GREEN_FINISHED
+};
+
+struct GreenWorker;
+
+typedef struct GreenThread {
+    unsigned context[GREEN_CONTEXT_WORDS];
+    struct GreenThread *next;     // Run queue or I/O queue link.
+    struct GreenWorker *worker;
+    int state;
+    void (*func)(void *);
+    void *arg;
+
+    // Pending I/O request, and its result.
+    int ioWrite;
+    char *ioBuffer;
+    int ioSize;
+    OpenFileId ioFile;
+    int ioResult;
+} GreenThread;
+
+typedef struct GreenWorker {
+    unsigned context[GREEN_CONTEXT_WORDS];  // The scheduler loop.
+    GreenThread *readyHead, *readyTail;
+    GreenThread *ioHead, *ioTail;
+    GreenThread *finished;  // To reclaim once off its stack.
+
+    // Statistics.
+    unsigned switches;
+    unsigned kernelCalls;
+} GreenWorker;
+
+void GreenSwitch(unsigned *from, unsigned *to);
+void GreenRoot(void);
+unsigned GreenStackPointer(void);
+
+static GreenThread greenThreads[GREEN_MAX_THREADS];
+static char greenStacks[GREEN_MAX_THREADS][GREEN_STACK_SIZE];
+static GreenWorker greenWorkers[GREEN_MAX_WORKERS];
+static unsigned greenNumWorkers = 1;
+static unsigned greenNextBinding;
+static int greenNextWorker;
+static Mutex greenPoolLock = MUTEX_INITIALIZER;
+
+/// The green thread running on the calling stack, or null if called from
+/// outside a green thread.
+static GreenThread *greenSelf(void) {
+    unsigned sp = GreenStackPointer();
+    unsigned base = (unsigned) greenStacks;
+    if (sp < base || sp >= base + sizeof greenStacks)
+        return NULL;
+    return &greenThreads[(sp - base) / GREEN_STACK_SIZE];
+}
+
+static void greenAppend(GreenThread **head, GreenThread **tail,
+                        GreenThread *t) {
+    t->next = NULL;
+    if (*head == NULL)
+        *head = t;
+    else
+        (*tail)->next = t;
+    *tail = t;
+}
+
+static GreenThread *greenPop(GreenThread **head, GreenThread **tail) {
+    GreenThread *t = *head;
+    if (t != NULL) {
+        *head = t->next;
+        if (*head == NULL)
+            *tail = NULL;
+    }
+    return t;
+}
+
+/// Release the slot of a thread that finished, now that nobody runs on its
+/// stack any more.
+static void greenReap(GreenWorker *w) {
+    if (w->finished != NULL) {
+        w->finished->state = GREEN_FREE;
+        w->finished = NULL;
+    }
+}
+
+/// Give the processor from `self`, which must already be queued wherever
+/// it belongs, to the next ready thread of its worker; or to the worker
+/// itself if there is none.
+static void greenSchedule(GreenThread *self) {
+    GreenWorker *w = self->worker;
+    GreenThread *next = greenPop(&w->readyHead, &w->readyTail);
+    w->switches++;
+    if (next != NULL) {
+        next->state = GREEN_RUNNING;
+        GreenSwitch(self->context, next->context);
+    } else {
+        GreenSwitch(self->context, w->context);
+    }
+    greenReap(w);
+}
+
+void greenInit(unsigned workers) {
+    if (workers == 0)
+        workers = 1;
+    if (workers > GREEN_MAX_WORKERS)
+        workers = GREEN_MAX_WORKERS;
+    greenNumWorkers = workers;
+}
+
+/// Create a green thread running `func(arg)`.
+///
+/// Called from a green thread, the new one goes to the same worker;
+/// otherwise, threads are spread over the workers in turn.
+///
+/// Return 0, or -1 if there are too many threads.
+int greenSpawn(void (*func)(void *), void *arg) {
+    GreenThread *t = NULL;
+    unsigned i;
+
+    mutexLock(&greenPoolLock);
+    for (i = 0; i < GREEN_MAX_THREADS; i++) {
+        if (greenThreads[i].state == GREEN_FREE) {
+            t = &greenThreads[i];
+            t->state = GREEN_READY;
+            break;
+        }
+    }
+    mutexUnlock(&greenPoolLock);
+    if (t == NULL)
+        return -1;
+
+    GreenThread *self = greenSelf();
+    if (self != NULL)
+        t->worker = self->worker;
+    else
+        t->worker = &greenWorkers[greenNextBinding++ % greenNumWorkers];
+
+    t->func = func;
+    t->arg  = arg;
+    for (i = 0; i < GREEN_CONTEXT_WORDS; i++)
+        t->context[i] = 0;
+    t->context[0] = (unsigned) t;  // `s0`, for `GreenRoot`.
+    t->context[GREEN_CONTEXT_SP] =
+        (unsigned) greenStacks[t - greenThreads] + GREEN_STACK_SIZE - 16;
+    t->context[GREEN_CONTEXT_RA] = (unsigned) GreenRoot;
+
+    greenAppend(&t->worker->readyHead, &t->worker->readyTail, t);
+    return 0;
+}
+
+/// Let other green threads of this worker run.  Cheap when none is ready.
+void greenYield(void) {
+    GreenThread *self = greenSelf();
+    if (self == NULL || self->worker->readyHead == NULL)
+        return;
+    self->state = GREEN_READY;
+    greenAppend(&self->worker->readyHead, &self->worker->readyTail, self);
+    greenSchedule(self);
+}
+
+/// Finish the calling green thread.
+void greenExit(void) {
+    GreenThread *self = greenSelf();
+    if (self == NULL)
+        return;
+    self->state = GREEN_FINISHED;
+    self->worker->finished = self;
+    greenSchedule(self);
+    // Not reached.
+}
+
+/// Entered through `GreenRoot` the first time a thread runs.
+void greenThreadMain(GreenThread *self) {
+    greenReap(self->worker);
+    self->func(self->arg);
+    greenExit();
+}
+
+static int greenIO(int write, char *buffer, int size, OpenFileId file) {
+    GreenThread *self = greenSelf();
+
+    // Nothing else to run: go straight to the kernel.
+    if (self == NULL || self->worker->readyHead == NULL) {
+        if (self != NULL)
+            self->worker->kernelCalls++;
+        return write ? Write(buffer, size, file) : Read(buffer, size, file);
+    }
+
+    self->ioWrite  = write;
+    self->ioBuffer = buffer;
+    self->ioSize   = size;
+    self->ioFile   = file;
+    self->state    = GREEN_BLOCKED;
+    greenAppend(&self->worker->ioHead, &self->worker->ioTail, self);
+    greenSchedule(self);
+    return self->ioResult;
+}
+
+int greenRead(char *buffer, int size, OpenFileId file) {
+    return greenIO(0, buffer, size, file);
+}
+
+int greenWrite(const char *buffer, int size, OpenFileId file) {
+    return greenIO(1, (char *) buffer, size, file);
+}
+
+/// Run the green threads of worker `w` until none is left.
+static void greenWorkerLoop(GreenWorker *w) {
+    for (;;) {
+        GreenThread *t = greenPop(&w->readyHead, &w->readyTail);
+        if (t == NULL) {
+            // Every thread left is blocked: do the oldest request.
+            t = greenPop(&w->ioHead, &w->ioTail);
+            if (t == NULL)
+                break;
+            w->kernelCalls++;
+            if (t->ioWrite)
+                t->ioResult = Write(t->ioBuffer, t->ioSize, t->ioFile);
+            else
+                t->ioResult = Read(t->ioBuffer, t->ioSize, t->ioFile);
+        }
+        t->state = GREEN_RUNNING;
+        w->switches++;
+        GreenSwitch(w->context, t->context);
+        greenReap(w);
+    }
+}
+
+static void greenWorkerMain(void) {
+    int i = atomicAdd(&greenNextWorker, 1);
+    greenWorkerLoop(&greenWorkers[i]);
+}
+
+/// Run every green thread to completion, on `greenNumWorkers` kernel
+/// threads: the caller and `greenNumWorkers - 1` forked ones.
+///
+/// Return the number of workers that could not be forked; their threads
+/// are run by the caller afterwards instead.
+int greenRun(void) {
+    int ids[GREEN_MAX_WORKERS];
+    unsigned forked, i;
+
+    // Forked workers take the numbers after 0 in order, so stop at the
+    // first failure.
+    greenNextWorker = 1;
+    for (forked = 0; forked + 1 < greenNumWorkers; forked++) {
+        ids[forked] = Fork(greenWorkerMain);
+        if (ids[forked] < 0)
+            break;
+    }
+
+    greenWorkerLoop(&greenWorkers[0]);
+    for (i = forked + 1; i < greenNumWorkers; i++)
+        greenWorkerLoop(&greenWorkers[i]);
+
+    for (i = 0; i < forked; i++)
+        Join(ids[i]);
+    return greenNumWorkers - 1 - forked;
+}
+
+static void greenPutNumber(const char *label, unsigned n) {
+    char buffer[12];
+    ourPuts(label);
+    itoa(n, buffer);
+    ourPuts(buffer);
+}
+
+void greenPrintStats(void) {
+    unsigned i;
+    for (i = 0; i < greenNumWorkers; i++) {
+        greenPutNumber("Green worker ", i);
+        greenPutNumber(": switches ", greenWorkers[i].switches);
+        greenPutNumber(", kernel I/O calls ", greenWorkers[i].kernelCalls);
+        ourPuts("\n");
+    }
+}
@@ -0,0 +1,64 @@
+/// Context switch for green threads; see `green.c`.
+///
+/// Only the registers that a MIPS procedure must preserve across calls are
+/// saved: `s0`-`s7`, `gp`, `sp`, `fp` and `ra`.  The caller of
+/// `GreenSwitch` already assumes every other register is clobbered, so a
+/// switch is just a procedure call, with no system call involved.
+///
+/// The layout of a context must match `GREEN_CONTEXT_WORDS` in `green.c`.
+
+
+        .text
+        .align  2
+
+/// void GreenSwitch(unsigned *from, unsigned *to)
+///
+/// Save the current context into `from`, and resume the one in `to`.
+        .globl  GreenSwitch
+        .ent    GreenSwitch
+GreenSwitch:
+        sw      $16, 0($4)
+        sw      $17, 4($4)
+        sw      $18, 8($4)
+        sw      $19, 12($4)
+        sw      $20, 16($4)
+        sw      $21, 20($4)
+        sw      $22, 24($4)
+        sw      $23, 28($4)
+        sw      $28, 32($4)
+        sw      $29, 36($4)
+        sw      $30, 40($4)
+        sw      $31, 44($4)
+
+        lw      $16, 0($5)
+        lw      $17, 4($5)
+        lw      $18, 8($5)
+        lw      $19, 12($5)
+        lw      $20, 16($5)
+        lw      $21, 20($5)
+        lw      $22, 24($5)
+        lw      $23, 28($5)
+        lw      $28, 32($5)
+        lw      $29, 36($5)
+        lw      $30, 40($5)
+        lw      $31, 44($5)
+        j       $31
+        .end    GreenSwitch
+
+/// Where a new green thread starts: `greenSpawn` leaves the thread in `s0`
+/// and this address in `ra`, so the first switch to it lands here.
+        .globl  GreenRoot
+        .ent    GreenRoot
+GreenRoot:
+        move    $4, $16
+        jal     greenThreadMain
+        // `greenThreadMain` does not return.
+        .end    GreenRoot
+
+/// unsigned GreenStackPointer(void)
+        .globl  GreenStackPointer
+        .ent    GreenStackPointer
+GreenStackPointer:
+        move    $2, $29
+        j       $31
+        .end    GreenStackPointer
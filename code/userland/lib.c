@@ -51,3 +51,85 @@ void itoa (int n , char *str) {
     reverse(str, i);
     return;
 }
+
+
+/// Mutexes and condition variables on top of futexes.
+///
+/// A mutex is a word holding 0 when unlocked, 1 when locked, and 2 when
+/// locked with (possibly) some thread blocked on it.  Locking and unlocking
+/// an uncontended mutex takes no system call at all.
+
+typedef struct {
+    int state;
+} Mutex;
+
+typedef struct {
+    int seq;      // Bumped on every signal.
+    int waiters;  // Threads in `CondWait`.
+} Cond;
+
+#define MUTEX_INITIALIZER  { 0 }
+#define COND_INITIALIZER   { 0, 0 }
+
+static int atomicExchange(int *addr, int value) {
+    int old;
+    do {
+        old = *addr;
+    } while (AtomicCompareAndSwap(addr, old, value) != old);
+    return old;
+}
+
+static int atomicAdd(int *addr, int delta) {
+    int old;
+    do {
+        old = *addr;
+    } while (AtomicCompareAndSwap(addr, old, old + delta) != old);
+    return old;
+}
+
+void mutexLock(Mutex *m) {
+    int c = AtomicCompareAndSwap(&m->state, 0, 1);
+    if (c == 0)
+        return;
+
+    // Contended: announce a waiter, and sleep until we get it.
+    if (c != 2)
+        c = atomicExchange(&m->state, 2);
+    while (c != 0) {
+        FutexWait(&m->state, 2);
+        c = atomicExchange(&m->state, 2);
+    }
+}
+
+int mutexTryLock(Mutex *m) {
+    return AtomicCompareAndSwap(&m->state, 0, 1) == 0;
+}
+
+void mutexUnlock(Mutex *m) {
+    if (atomicExchange(&m->state, 0) == 2)
+        FutexWake(&m->state, 1);
+}
+
+void condWait(Cond *c, Mutex *m) {
+    int seq = c->seq;
+    atomicAdd(&c->waiters, 1);
+    mutexUnlock(m);
+    FutexWait(&c->seq, seq);  // Returns at once if signalled meanwhile.
+    atomicAdd(&c->waiters, -1);
+
+    // Others may be blocked on the mutex too, so lock it as contended.
+    while (atomicExchange(&m->state, 2) != 0)
+        FutexWait(&m->state, 2);
+}
+
+void condSignal(Cond *c) {
+    atomicAdd(&c->seq, 1);
+    if (c->waiters > 0)
+        FutexWake(&c->seq, 1);
+}
+
+void condBroadcast(Cond *c) {
+    atomicAdd(&c->seq, 1);
+    if (c->waiters > 0)
+        FutexWake(&c->seq, c->waiters);
+}
@@ -19,6 +19,14 @@
         .globl  __start
         .ent    __start
 __start:
+        // Register the atomic sequence, keeping `argc` and `argv`.
+        move    $16, $4
+        move    $17, $5
+        la      $4, __atomic_begin
+        la      $5, __atomic_end
+        jal     RegisterAtomicSequence
+        move    $4, $16
+        move    $5, $17
         jal     main
         // If `main` returns, invoke `Exit` with the return value as
         // argument.
@@ -72,11 +80,20 @@ Join:
         .globl  Fork
         .ent    Fork
 Fork:
+        // Pass the kernel where the new thread returns to once `func` is
+        // done: `__fork_exit` calls `Exit` with the value `func` returned.
+        la      $5, __fork_exit
         addiu   $2, $0, SC_FORK
         syscall
         j       $31
         .end    Fork
 
+        .ent    __fork_exit
+__fork_exit:
+        move    $4, $2
+        jal     Exit
+        .end    __fork_exit
+
         .globl  Yield
         .ent    Yield
 Yield:
@@ -85,6 +102,61 @@ Yield:
         j       $31
         .end    Yield
 
+        .globl  Sleep
+        .ent    Sleep
+Sleep:
+        addiu   $2, $0, SC_SLEEP
+        syscall
+        j       $31
+        .end    Sleep
+
+        .globl  FutexWait
+        .ent    FutexWait
+FutexWait:
+        addiu   $2, $0, SC_FUTEX_WAIT
+        syscall
+        j       $31
+        .end    FutexWait
+
+        .globl  FutexWake
+        .ent    FutexWake
+FutexWake:
+        addiu   $2, $0, SC_FUTEX_WAKE
+        syscall
+        j       $31
+        .end    FutexWake
+
+        .globl  RegisterAtomicSequence
+        .ent    RegisterAtomicSequence
+RegisterAtomicSequence:
+        addiu   $2, $0, SC_ATOMIC_SEQUENCE
+        syscall
+        j       $31
+        .end    RegisterAtomicSequence
+
+/// Atomic compare and swap, as a restartable sequence.
+///
+/// MIPS1 has no atomic read-modify-write instruction.  Instead, the kernel
+/// restarts this sequence from `__atomic_begin` whenever the thread is
+/// switched out before the store at its end has executed, so the load,
+/// the comparison and the store look atomic to other threads.  The
+/// sequence must stay free of side effects before that store.
+        .globl  AtomicCompareAndSwap
+        .ent    AtomicCompareAndSwap
+AtomicCompareAndSwap:
+        .set    noreorder
+__atomic_begin:
+        lw      $2, 0($4)
+        nop                     // Load delay slot.
+        bne     $2, $5, 1f
+        nop                     // Branch delay slot.
+        sw      $6, 0($4)
+__atomic_end:
+1:      j       $31
+        nop
+        .set    reorder
+        .end    AtomicCompareAndSwap
+
         .globl  Create
         .ent    Create
 Create:
@@ -0,0 +1,55 @@
+/// Compare the cost of switching between green threads and between kernel
+/// threads.
+///
+/// A few threads take turns yielding the processor, `ROUNDS` times each.
+/// Run `switchbench` for green threads, and `switchbench kernel` for kernel
+/// threads created with `Fork`; then compare the `Ticks` line that Nachos
+/// prints when it halts.  Green switches are spent in user mode, kernel
+/// ones mostly in system mode.
+
+
+#include "syscall.h"
+#include "lib.c"
+#include "green.c"
+
+#define THREADS  4
+#define ROUNDS   200
+
+static void greenBody(void *arg) {
+    unsigned i;
+    for (i = 0; i < ROUNDS; i++)
+        greenYield();
+}
+
+static void kernelBody(void) {
+    unsigned i;
+    for (i = 0; i < ROUNDS; i++)
+        Yield();
+}
+
+int
+main(int argc, char **argv)
+{
+    unsigned i;
+
+    if (argc > 1 && argv[1][0] == 'k') {
+        int ids[THREADS];
+        for (i = 0; i < THREADS; i++)
+            ids[i] = Fork(kernelBody);
+        for (i = 0; i < THREADS; i++)
+            if (ids[i] >= 0)
+                Join(ids[i]);
+        ourPuts("Kernel threads done.\n");
+    } else {
+        greenInit(1);
+        for (i = 0; i < THREADS; i++)
+            greenSpawn(greenBody, NULL);
+        greenRun();
+        greenPrintStats();
+        ourPuts("Green threads done.\n");
+    }
+
+    Halt();
+    // Not reached.
+    return 0;
+}
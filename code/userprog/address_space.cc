@@ -10,65 +10,80 @@
 #include "exception_type.hh"
 #include "threads/system.hh"
 #include "lib/utility.hh"
-#include "filesys/directory_entry.hh"
 #include "executable.hh"
 #include <stdio.h>
 #include <string.h>
 
+
+/// Number of pages in the stack of a forked thread.
+static inline unsigned
+UserStackPages()
+{
+    return DivRoundUp(USER_STACK_SIZE, PAGE_SIZE);
+}
+
 int
 AddressSpace::addPage(unsigned vpn){
-  int frame = pages->Find(); 
-  DEBUG('a', "Frame selected for page %u is %d\n", vpn, frame);
   #ifdef SWAP
+  int frame = coreMap->Allocate(this, vpn);
   if(frame == -1) { // No hay suficiente espacio
-    int victim = pages->PickVictim(machine->GetNumPhysicalPages());
-    DEBUG('a', "Freeing up frame %d for page %u\n", victim, vpn);
-
-    unsigned oldVpn = pages->GetVPN(victim);
-    ASSERT(oldVpn != (unsigned) -1);
-    Thread *oldThread = pages->GetThread(victim);
-    ASSERT(oldThread != nullptr);
-    TranslationEntry *oldEntry = oldThread->space->GetEntry(oldVpn);
-
-    // Invalidates tlb and page table entries.
-    for (unsigned i = 0; i < TLB_SIZE; i++)
-        if (machine->GetMMU()->tlb[i].valid && machine->GetMMU()->tlb[i].physicalPage == (unsigned) victim){ //Actualizo los bits
-          oldEntry->use = machine->GetMMU()->tlb[i].use;
-          oldEntry->dirty = machine->GetMMU()->tlb[i].dirty;
-          machine->GetMMU()->tlb[i].valid = false;
-        }
+    // The policy leaves the victim's page table entry up to date and
+    // unmapped from the TLB.
+    unsigned victim = coreMap->PickVictim();
+    DEBUG('a', "Freeing up frame %u for page %u\n", victim, vpn);
 
-    
-    // If it's a dirty page, swap it on disk.
-    //if (oldEntry->dirty || !oldThread->space->swapMap->Test(oldVpn))
-        oldThread->space->SwapPage(oldVpn);
+    unsigned oldVpn = coreMap->GetVpn(victim);
+    AddressSpace *oldSpace = coreMap->GetSpace(victim);
 
-    pages->RemoveEntry(victim);
+    oldSpace->SwapPage(oldVpn);
 
-    frame = pages->Find();
+    coreMap->Free(victim);
+    frame = coreMap->Allocate(this, vpn);
     ASSERT(frame != -1);
-    pages->AddEntry(frame, vpn, currentThread);
-  }
-  else{
-    pages->AddEntry(frame, vpn, currentThread);
   }
+  #else
+  int frame = pages->Find();
   #endif
-  
+  DEBUG('a', "Frame selected for page %u is %d\n", vpn, frame);
+
   return frame;
 }
 
 #ifdef SWAP
 void
-AddressSpace::SwapPage(unsigned vpn) {
-  DEBUG('a', "Writing virtual page %u on disk.\n", vpn);
+AddressSpace::CleanPage(unsigned vpn) {
+  ASSERT(pageTable[vpn].physicalPage != (unsigned) -1);
 
+  if (swapSlots[vpn] == -1) {
+    swapSlots[vpn] = swapArea->Allocate();
+    ASSERT(swapSlots[vpn] != -1);  // Out of swap space.
+  }
+  DEBUG('a', "Writing virtual page %u to swap slot %d.\n",
+        vpn, swapSlots[vpn]);
   unsigned physicalAddress = pageTable[vpn].physicalPage * PAGE_SIZE;
-  char* mainMemory = machine->mainMemory;
-  swapFile->WriteAt(&mainMemory[physicalAddress], PAGE_SIZE, vpn * PAGE_SIZE);
+  swapArea->Write(swapSlots[vpn], &machine->mainMemory[physicalAddress]);
+  coreMap->ClearDirty(pageTable[vpn].physicalPage);
+}
+
+void
+AddressSpace::SwapPage(unsigned vpn) {
+  if (pageTable[vpn].dirty) {
+    CleanPage(vpn);
+  } else {
+    DEBUG('a', "Dropping clean virtual page %u.\n", vpn);
+  }
 
   pageTable[vpn].physicalPage = -1;
-  swapMap->Mark(vpn);
-  stats->numSwappedPages++;
+  pageTable[vpn].dirty = false;
+  pageTable[vpn].use   = false;
+}
+
+void
+AddressSpace::FreeSwapSlot(unsigned vpn) {
+  if (swapSlots[vpn] != -1) {
+    swapArea->Free(swapSlots[vpn]);
+    swapSlots[vpn] = -1;
+  }
 }
 
 #endif
@@ -79,33 +94,38 @@ AddressSpace::SwapPage(unsigned vpn) {
 AddressSpace::AddressSpace(OpenFile *executable_file, Thread* thread)
 {
     ASSERT(executable_file != nullptr);
-    exe_file = executable_file;
-    Executable exe = (executable_file);
-    ASSERT(exe.CheckMagic());
+    // The header is read once; with demand loading, pages are loaded
+    // from the file as long as the address space lives.
+    executable = new Executable(executable_file);
+    ASSERT(executable->CheckMagic());
+    Executable &exe = *executable;
+    atomicBegin = atomicEnd = 0;
+    references = 1;
+    lastMiss = 0;
+    lastStride = 0;
 
     // How big is address space?
 
     unsigned size = exe.GetSize() + USER_STACK_SIZE;
       // We need to increase the size to leave room for the stack.
-    numPages = DivRoundUp(size, PAGE_SIZE);
+    mainPages = DivRoundUp(size, PAGE_SIZE);
+      // Then leave room for the stacks of forked threads.
+    numPages = mainPages + MAX_USER_THREADS * UserStackPages();
     size = numPages * PAGE_SIZE;
+    stackSlots = new Bitmap(MAX_USER_THREADS);
 
     #ifndef SWAP
       // Check we are not trying to run anything too big
-      ASSERT(numPages <= machine->GetNumPhysicalPages());
-      ASSERT(numPages <= pages->CountClear());
+      ASSERT(mainPages <= machine->GetNumPhysicalPages());
+      ASSERT(mainPages <= pages->CountClear());
     #endif
 
     #ifdef SWAP
-      // Initialize swap file.
-      DEBUG('a', "Initialize swap file\n");
-      char swapFileName[FILE_NAME_MAX_LEN];
-      snprintf(swapFileName, FILE_NAME_MAX_LEN, "SWAP.%u", thread->pid);
-      fileSystem->Create(swapFileName, size);
-      swapFile = fileSystem->Open(swapFileName);
-      ASSERT(swapFile);
-      threadPid = thread->pid;
-      swapMap = new Bitmap(numPages);
+      // Pages get swap slots when first written out.
+      swapSlots = new int [numPages];
+      for (unsigned i = 0; i < numPages; i++) {
+          swapSlots[i] = -1;
+      }
     #endif
 
     DEBUG('a', "Initializing address space, num pages %u, size %u\n",
@@ -128,6 +148,12 @@ AddressSpace::AddressSpace(OpenFile *executable_file, Thread* thread)
           // If the code segment was entirely on a separate page, we could
           // set its pages to be read-only.
         #ifndef DEMAND_LOADING
+          if (i >= mainPages) {
+              // Stack slots get their memory when a thread is forked.
+              pageTable[i].valid        = false;
+              pageTable[i].physicalPage = -1;
+              continue;
+          }
           pageTable[i].physicalPage = addPage(i); //pageTable[i].physicalPage = pages->Find(); // = i;
           memset(&mainMemory[pageTable[i].physicalPage * PAGE_SIZE], 0, PAGE_SIZE);
         #else
@@ -211,75 +237,243 @@ AddressSpace::AddressSpace(OpenFile *executable_file, Thread* thread)
     #endif
 }
 
+/// Frames that pages can be loaded into ahead of time: free frames beyond
+/// the reserve kept by the pageout daemon, if any.
+static unsigned
+SpareFrames()
+{
+#ifdef SWAP
+    unsigned reserve = pageoutDaemon != nullptr
+                       ? pageoutDaemon->GetLowWater() : 0;
+    unsigned numFree = coreMap->CountFree();
+    return numFree > reserve ? numFree - reserve : 0;
+#else
+    return pages->CountClear();
+#endif
+}
+
 TranslationEntry*
 AddressSpace::LoadPage(unsigned vpn) {
-  //DEBUG('e', "Load requested for page %u\n", vpn);
-  if(pageTable[vpn].physicalPage != (unsigned) -1) // La pagina ya esta cargada
-    return &pageTable[vpn];
+  #ifdef SWAP
+  // Before looking at the page: other threads of this space may run
+  // meanwhile, and load it.
+  if (pageoutDaemon != nullptr) {
+    pageoutDaemon->Check();
+  }
+  #endif
+
+  if (pageTable[vpn].physicalPage == (unsigned) -1) {
+    stats->numPageFaults++;
+
+    // Fault around: the whole window, if it is in the same segment.
+    unsigned first = vpn, last = vpn;
+    Segment segment = SegmentOf(vpn);
+    if (segment != SEGMENT_ZERO) {
+      first = vpn - vpn % FAULT_AROUND_PAGES;
+      last = first + FAULT_AROUND_PAGES - 1;
+      if (last >= mainPages) {
+        last = mainPages - 1;
+      }
+      while (SegmentOf(first) != segment) {
+        first++;
+      }
+      while (SegmentOf(last) != segment) {
+        last--;
+      }
+    }
+    LoadPages(first, last, vpn);
+  }
+
+  ReadAhead(vpn);
+  return &pageTable[vpn];
+}
+
+AddressSpace::Segment
+AddressSpace::SegmentOf(unsigned vpn) const
+{
+  uint32_t start = vpn * PAGE_SIZE, end = start + PAGE_SIZE;
+  uint32_t codeAddr = executable->GetCodeAddr();
+  uint32_t dataAddr = executable->GetInitDataAddr();
+  if (codeAddr < end && codeAddr + executable->GetCodeSize() > start) {
+    return SEGMENT_CODE;
+  }
+  if (dataAddr < end && dataAddr + executable->GetInitDataSize() > start) {
+    return SEGMENT_DATA;
+  }
+  return SEGMENT_ZERO;
+}
+
+/// Until page `required` is in, a neighbour is only loaded if a frame is
+/// left for it afterwards: were `required` to evict, the victim could be a
+/// neighbour just loaded, still waiting for its contents.
+void
+AddressSpace::LoadPages(unsigned first, unsigned last, int required)
+{
+  ASSERT(first <= last && last < numPages);
+  ASSERT(last - first < FAULT_AROUND_PAGES);
 
+  bool pending = required >= (int) first && required <= (int) last
+                 && pageTable[required].physicalPage == (unsigned) -1;
   char *mainMemory = machine->mainMemory;
-  pageTable[vpn].physicalPage = addPage(vpn);
-  uint32_t physicalAddr = pageTable[vpn].physicalPage * PAGE_SIZE;
-  memset(&mainMemory[physicalAddr], 0, PAGE_SIZE);
+  unsigned fromExecutable[FAULT_AROUND_PAGES];
+  unsigned count = 0;
+  for (unsigned vpn = first; vpn <= last; vpn++) {
+    if (pageTable[vpn].physicalPage != (unsigned) -1) {
+      continue;
+    }
+    if (vpn == (unsigned) required) {
+      pending = false;
+    } else {
+      if (SpareFrames() <= (pending ? 1u : 0u)) {
+        continue;
+      }
+      stats->numPrefetchedPages++;
+    }
 
-  #ifdef SWAP
-  if(swapMap->Test(vpn)){ // Ya esta cargada en swap
-    DEBUG('a', "La pagina %d esta en swap\n",vpn);
-    //swapMap->Clear(vpn);
-    swapFile->ReadAt(&(mainMemory[physicalAddr]), PAGE_SIZE, vpn * PAGE_SIZE);
-    return &pageTable[vpn];
+    int frame = addPage(vpn);
+    ASSERT(frame != -1);
+    pageTable[vpn].physicalPage = frame;
+    // The page starts clean: it matches its copy in swap, or where it is
+    // loaded from.
+    pageTable[vpn].dirty = false;
+    pageTable[vpn].use   = false;
+
+    #ifdef SWAP
+    if (swapSlots[vpn] != -1) {
+      DEBUG('a', "Reading page %u from swap slot %d\n", vpn, swapSlots[vpn]);
+      swapArea->Read(swapSlots[vpn], &mainMemory[frame * PAGE_SIZE]);
+      continue;
+    }
+    #endif
+    if (SegmentOf(vpn) == SEGMENT_ZERO) {
+      DEBUG('a', "Zero filling page %u in frame %d\n", vpn, frame);
+      memset(&mainMemory[frame * PAGE_SIZE], 0, PAGE_SIZE);
+    } else {
+      fromExecutable[count++] = vpn;
+    }
   }
-  #endif
 
+  if (count > 0) {
+    ReadExecutable(fromExecutable, count);
+  }
+}
+
+/// The pages span at most a window, so each segment is read with a single
+/// call, into a buffer laid out as the pages, which are then copied to
+/// their frames.  A page whose frame was taken back meanwhile is skipped;
+/// it will be loaded again when next touched.
+void
+AddressSpace::ReadExecutable(const unsigned *vpns, unsigned count)
+{
+  ASSERT(vpns != nullptr);
+  ASSERT(count > 0 && vpns[count - 1] - vpns[0] < FAULT_AROUND_PAGES);
+
+  char buffer[FAULT_AROUND_PAGES * PAGE_SIZE];
+  uint32_t start = vpns[0] * PAGE_SIZE;
+  uint32_t end = (vpns[count - 1] + 1) * PAGE_SIZE;
+  memset(buffer, 0, end - start);
+  DEBUG('a', "Loading pages %u to %u from the executable\n",
+        vpns[0], vpns[count - 1]);
+
+  uint32_t codeAddr = executable->GetCodeAddr();
+  uint32_t from = codeAddr > start ? codeAddr : start;
+  uint32_t to = codeAddr + executable->GetCodeSize();
+  if (to > end) {
+    to = end;
+  }
+  if (from < to) {
+    executable->ReadCodeBlock(&buffer[from - start], to - from,
+                              from - codeAddr);
+  }
+
+  uint32_t dataAddr = executable->GetInitDataAddr();
+  from = dataAddr > start ? dataAddr : start;
+  to = dataAddr + executable->GetInitDataSize();
+  if (to > end) {
+    to = end;
+  }
+  if (from < to) {
+    executable->ReadDataBlock(&buffer[from - start], to - from,
+                              from - dataAddr);
+  }
 
-  Executable exe = (exe_file);
-  uint32_t codeSize = exe.GetCodeSize();
-  uint32_t initDataSize = exe.GetInitDataSize();
-  unsigned exePos = (vpn * PAGE_SIZE); // Nuestra posicion en el exe
+  for (unsigned i = 0; i < count; i++) {
+    if (pageTable[vpns[i]].physicalPage == (unsigned) -1) {
+      continue;
+    }
+    unsigned physicalAddr = pageTable[vpns[i]].physicalPage * PAGE_SIZE;
+    memcpy(&machine->mainMemory[physicalAddr],
+           &buffer[(vpns[i] - vpns[0]) * PAGE_SIZE], PAGE_SIZE);
+  }
+}
+
+/// A stride is taken as such once two misses in a row follow it.  Pages
+/// are loaded some way ahead, so that they are read in batches rather than
+/// one per miss: when the page half a window ahead is missing, a window's
+/// worth of pages along the stride is loaded.
+void
+AddressSpace::ReadAhead(unsigned vpn)
+{
+  int stride = (int) vpn - (int) lastMiss;
+  bool followed = stride != 0 && stride == lastStride;
+  lastMiss   = vpn;
+  lastStride = stride;
+  if (!followed) {
+    return;
+  }
 
-  // Stack
-  if (exePos > codeSize + initDataSize) {
-    DEBUG('a', "Initializing stack page %u, physical address 0x%X\n", vpn, physicalAddr);
-    pageTable[vpn].readOnly = false;
+  int ahead = (int) vpn + stride * (int) (FAULT_AROUND_PAGES / 2);
+  if (ahead < 0 || ahead >= (int) mainPages
+        || pageTable[ahead].physicalPage != (unsigned) -1) {
+    return;
   }
 
-  else{
-    // Es de codigo
-    if(exePos < codeSize){
-      DEBUG('a', "Initializing code page %u, physical address 0x%X\n", vpn, physicalAddr);
-      uint32_t bytesToRead = PAGE_SIZE;//codeSize - exePos > PAGE_SIZE ? PAGE_SIZE : (codeSize - exePos);
-      exe.ReadCodeBlock(&mainMemory[physicalAddr], bytesToRead, exePos);
-      //pageTable[vpn].readOnly = true;
+  if (stride == 1 || stride == -1) {
+    // Sequential: the next pages, in one go.
+    int first = (int) vpn + stride;
+    int last = (int) vpn + stride * (int) FAULT_AROUND_PAGES;
+    if (first > last) {
+      int t = first; first = last; last = t;
     }
-    // Es de data
-    else {
-      DEBUG('a', "Initializing data page %u, physical address 0x%X\n", vpn, physicalAddr);
-      uint32_t bytesToRead =PAGE_SIZE; // (initDataSize + codeSize) - exePos > PAGE_SIZE ? PAGE_SIZE : (initDataSize + codeSize) - exePos ;
-      exe.ReadDataBlock(&mainMemory[physicalAddr], bytesToRead, (initDataSize + codeSize) - exePos);
-      pageTable[vpn].readOnly = false;
+    first = first < 0 ? 0 : first;
+    last = last >= (int) mainPages ? (int) mainPages - 1 : last;
+    LoadPages(first, last, -1);
+  } else {
+    for (unsigned i = 1; i <= FAULT_AROUND_PAGES; i++) {
+      int page = (int) vpn + stride * (int) i;
+      if (page < 0 || page >= (int) mainPages) {
+        break;
+      }
+      LoadPages(page, page, -1);
     }
   }
- 
-  return &pageTable[vpn];
 }
 
 
 /// Deallocate an address space.
 ///
-/// Nothing for now!
+/// Only called once the last thread using it is gone; see
+/// `RemoveReference`.
 AddressSpace::~AddressSpace()
 {
+    ASSERT(references == 0);
+    delete stackSlots;
+    delete executable;
     for (unsigned i = 0; i < numPages; i++) {
       if(pageTable[i].physicalPage != (unsigned) -1)
+      #ifdef SWAP
+        coreMap->Free(pageTable[i].physicalPage);
+      #else
         pages->Clear(pageTable[i].physicalPage); // = i; 
+      #endif
     }
-    delete [] pageTable;
-
     #ifdef SWAP
-      char swapFileName[FILE_NAME_MAX_LEN];
-      snprintf(swapFileName, FILE_NAME_MAX_LEN, "SWAP.%u", threadPid);
-      fileSystem->Remove(swapFileName);
+      for (unsigned i = 0; i < numPages; i++) {
+          FreeSwapSlot(i);
+      }
+      delete [] swapSlots;
     #endif
+    delete [] pageTable;
 }
 
 /// Set the initial values for the user-level register set.
@@ -305,9 +499,95 @@ AddressSpace::InitRegisters()
     // Set the stack register to the end of the address space, where we
     // allocated the stack; but subtract off a bit, to make sure we do not
     // accidentally reference off the end!
-    machine->WriteRegister(STACK_REG, numPages * PAGE_SIZE - 16);
+    machine->WriteRegister(STACK_REG, mainPages * PAGE_SIZE - 16);
     DEBUG('a', "Initializing stack register to %u\n",
-          numPages * PAGE_SIZE - 16);
+          mainPages * PAGE_SIZE - 16);
+}
+
+void
+AddressSpace::AddReference()
+{
+    references++;
+}
+
+bool
+AddressSpace::RemoveReference()
+{
+    ASSERT(references > 0);
+    return --references == 0;
+}
+
+/// Stack slots are laid out one after the other, starting right after the
+/// stack of the main thread.  Without demand loading, the pages of a slot
+/// are only backed by memory while it is in use, and are invalid otherwise,
+/// so that stray references to them fault.
+int
+AddressSpace::AllocateStack()
+{
+    int slot = stackSlots->Find();
+    if (slot == -1) {
+        DEBUG('a', "No stack slot left\n");
+        return -1;
+    }
+
+    #ifndef DEMAND_LOADING
+      #ifndef SWAP
+        if (pages->CountClear() < UserStackPages()) {
+            DEBUG('a', "Not enough memory for the stack of slot %d\n", slot);
+            stackSlots->Clear(slot);
+            return -1;
+        }
+      #endif
+      char *mainMemory = machine->mainMemory;
+      unsigned first = mainPages + slot * UserStackPages();
+      for (unsigned i = first; i < first + UserStackPages(); i++) {
+          pageTable[i].physicalPage = addPage(i);
+          pageTable[i].valid        = true;
+          pageTable[i].use          = false;
+          pageTable[i].dirty        = false;
+          memset(&mainMemory[pageTable[i].physicalPage * PAGE_SIZE], 0,
+                 PAGE_SIZE);
+      }
+    #endif
+
+    DEBUG('a', "Allocated stack slot %d, top at %u\n", slot, StackTop(slot));
+    return slot;
+}
+
+/// With demand loading the pages stay valid, and are zero filled again by
+/// `LoadPage` the next time the slot is used.
+void
+AddressSpace::FreeStack(int slot)
+{
+    ASSERT(slot >= 0 && (unsigned) slot < MAX_USER_THREADS);
+    ASSERT(stackSlots->Test(slot));
+
+    unsigned first = mainPages + slot * UserStackPages();
+    for (unsigned i = first; i < first + UserStackPages(); i++) {
+        if (pageTable[i].physicalPage != (unsigned) -1) {
+          #ifdef SWAP
+            coreMap->Free(pageTable[i].physicalPage);
+          #else
+            pages->Clear(pageTable[i].physicalPage);
+          #endif
+            pageTable[i].physicalPage = -1;
+        }
+        #ifdef SWAP
+          FreeSwapSlot(i);
+        #endif
+        #ifndef DEMAND_LOADING
+          pageTable[i].valid = false;
+        #endif
+    }
+    stackSlots->Clear(slot);
+    DEBUG('a', "Freed stack slot %d\n", slot);
+}
+
+unsigned
+AddressSpace::StackTop(int slot) const
+{
+    ASSERT(slot >= 0 && (unsigned) slot < MAX_USER_THREADS);
+    return (mainPages + (slot + 1) * UserStackPages()) * PAGE_SIZE;
 }
 
 /// On a context switch, save any machine state, specific to this address
@@ -326,15 +606,13 @@ void
 AddressSpace::RestoreState()
 {
   #ifdef  USE_TLB
+    // Guardar bit de referencia y de modificacion en la pagina de tablas
+    // correspondiente; the entries may belong to any address space, since
+    // kernel threads run in between without flushing them.
+    #ifdef SWAP
+      coreMap->SyncTlb();
+    #endif
     for(unsigned i = 0; i < TLB_SIZE; i++) {
-      // Guardar bit de referencia y de modificacion en la pagina de tablas correspondiente
-      //unsigned oldVpn = machine->GetMMU()->tlb[i].virtualPage;
-      //TranslationEntry *oldEntry = currentThread->space->GetEntry(oldVpn);
-      //if(oldEntry != nullptr){
-      //  oldEntry->use = machine->GetMMU()->tlb[i].use;
-      //  oldEntry->dirty = machine->GetMMU()->tlb[i].dirty;
-      //}
-
       machine->GetMMU()->tlb[i].valid = false;
     }
   #endif
@@ -345,6 +623,27 @@ AddressSpace::RestoreState()
   #endif
 }
 
+bool
+AddressSpace::SetAtomicSequence(unsigned begin, unsigned end)
+{
+    if (begin >= end || end - begin > MAX_ATOMIC_SEQUENCE
+          || end > numPages * PAGE_SIZE) {
+        return false;
+    }
+    atomicBegin = begin;
+    atomicEnd   = end;
+    return true;
+}
+
+unsigned
+AddressSpace::RestartPoint(unsigned pc) const
+{
+    if (atomicBegin <= pc && pc < atomicEnd) {
+        return atomicBegin;
+    }
+    return pc;
+}
+
 TranslationEntry*
 AddressSpace::GetEntry(unsigned vpn){
   return &pageTable[vpn];
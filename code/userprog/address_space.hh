@@ -17,8 +17,26 @@
 #include "machine/translation_entry.hh"
 #include "lib/bitmap.hh"
 
+
+class Executable;
+class Thread;
+
 const unsigned USER_STACK_SIZE = 1024;  ///< Increase this as necessary!
 
+/// Maximum number of threads forked by a user program that can be alive at
+/// the same time.  Each of them gets a stack of `USER_STACK_SIZE` bytes
+/// above the stack of the main thread.
+const unsigned MAX_USER_THREADS = 8;
+
+/// Longest restartable atomic sequence accepted, in bytes.
+const unsigned MAX_ATOMIC_SEQUENCE = 64;
+
+/// Pages loaded together on a page fault, with demand loading: the
+/// faulting page and its neighbours in an aligned window of this many
+/// pages.  Also the number of pages read ahead when faults follow a
+/// stride.
+const unsigned FAULT_AROUND_PAGES = 4;
+
 class AddressSpace {
 public:
 
@@ -40,19 +58,70 @@ public:
     /// Initialize user-level CPU registers, before jumping to user code.
     void InitRegisters();
 
+    /// Address spaces are shared by every thread of a user program, and are
+    /// only deleted when the last of them goes away.  A new address space
+    /// starts with one reference, held by the thread that loads it.
+
+    void AddReference();
+
+    /// Drop a reference; return true if it was the last one, in which case
+    /// the caller must delete the address space.
+    bool RemoveReference();
+
+    /// Reserve a stack for a new thread of the program.
+    ///
+    /// Return the number of the stack slot, or -1 if every slot is taken
+    /// or there is no memory left for the stack.
+    int AllocateStack();
+
+    /// Give back the stack slot `slot`, and the memory it uses.
+    void FreeStack(int slot);
+
+    /// Virtual address just past the top of the stack in slot `slot`.
+    unsigned StackTop(int slot) const;
+
     /// Save/restore address space-specific info on a context switch.
 
     void SaveState();
     void RestoreState();
 
+    /// Register the program's restartable atomic sequence: the code
+    /// between `begin` and `end`, which must run without interleaving with
+    /// other threads of the program.  There is no atomic instruction in
+    /// the MIPS1 instruction set, so a thread switched out inside the
+    /// sequence starts it over when it resumes.
+    ///
+    /// Return false if the range is not acceptable.
+    bool SetAtomicSequence(unsigned begin, unsigned end);
+
+    /// Where a thread switched out at `pc` must resume: the start of the
+    /// atomic sequence if `pc` lies inside it, `pc` otherwise.
+    unsigned RestartPoint(unsigned pc) const;
+
+    /// Make sure page `vpn` is in memory, and return its entry.  To be
+    /// called on every TLB miss.
+    ///
+    /// A page that is not in memory is brought in together with the
+    /// neighbours of its window that belong to the same segment, if there
+    /// are frames to spare; their contents are read from the executable
+    /// at once.  Misses that follow a stride make the pages ahead along
+    /// the stride be loaded as well.
     TranslationEntry* LoadPage(unsigned vpn);
 
     TranslationEntry* GetEntry(unsigned vpn);
 
     int addPage(unsigned vpn);
 
+    /// Take page `vpn` out of memory, writing it to swap if it changed
+    /// since it was last written, or loaded.  Clean pages can be brought
+    /// back from their copy in swap or, if they have none, from the
+    /// executable (or zero filled).
     void SwapPage(unsigned vpn);
 
+    /// Write page `vpn`, which must be in memory, to swap, and mark it
+    /// clean.  The page stays where it is.
+    void CleanPage(unsigned vpn);
+
     void RemovePage();
 
 private:
@@ -63,12 +132,53 @@ private:
     /// Number of pages in the virtual address space.
     unsigned numPages;
 
-    OpenFile* exe_file;
+    /// Pages taken by the program and the stack of its main thread; the
+    /// stack slots of forked threads follow them.
+    unsigned mainPages;
+
+    /// Which stack slots are in use.
+    Bitmap *stackSlots;
+
+    /// Number of threads using this address space.
+    unsigned references;
+
+    /// The program, with its header read once.
+    Executable *executable;
+
+    /// Page of the last TLB miss, and its distance from the one before,
+    /// to detect misses that follow a stride.
+    unsigned lastMiss;
+    int lastStride;
+
+    /// The first segment of the executable that page `vpn` overlaps:
+    /// code, initialized data, or neither, for pages that start zero
+    /// filled.
+    enum Segment { SEGMENT_CODE, SEGMENT_DATA, SEGMENT_ZERO };
+    Segment SegmentOf(unsigned vpn) const;
+
+    /// Bring in the pages from `first` to `last` that are not in memory,
+    /// which must fit in a window.  Only frames to spare are taken, except
+    /// for page `required`, if it is one of them; -1 for none.  Page
+    /// `required` is always loaded, and never at the expense of another
+    /// page of the range.
+    void LoadPages(unsigned first, unsigned last, int required);
+
+    /// Fill the `count` pages of `vpns`, in increasing order and in memory
+    /// already, with their contents in the executable.
+    void ReadExecutable(const unsigned *vpns, unsigned count);
+
+    /// Load the pages ahead of a miss on `vpn`, if misses follow a stride.
+    void ReadAhead(unsigned vpn);
+
+    /// Restartable atomic sequence, empty if none.
+    unsigned atomicBegin, atomicEnd;
     
     #ifdef SWAP
-        OpenFile* swapFile;
-        int threadPid;
-        Bitmap * swapMap;
+        /// Slot in the swap area holding a copy of each page, or -1.
+        int *swapSlots;
+
+        /// Give back the swap slot of page `vpn`, if it has one.
+        void FreeSwapSlot(unsigned vpn);
     #endif
 };
 
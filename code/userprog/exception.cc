@@ -85,6 +85,38 @@ void runProgram(void* argv_)
     machine->Run();
 }
 
+/// Where a thread created by `Fork` enters user code.
+struct UserThreadStart {
+    unsigned func;    ///< Procedure to run.
+    unsigned exitPC;  ///< Where `func` returns to; it calls `Exit`.
+};
+
+/// Start running a thread forked by a user program.  It shares the
+/// address space of its parent, and only needs its registers set up: the
+/// program counter at `func`, the stack pointer at the top of its own
+/// stack slot, and the return address at the exit trampoline passed by
+/// the `Fork` stub, so that returning from `func` finishes the thread.
+static void
+runUserThread(void *start_)
+{
+    UserThreadStart *start = (UserThreadStart *) start_;
+    AddressSpace *space = currentThread->space;
+
+    for (unsigned i = 0; i < NUM_TOTAL_REGS; i++) {
+        machine->WriteRegister(i, 0);
+    }
+    machine->WriteRegister(PC_REG, start->func);
+    machine->WriteRegister(NEXT_PC_REG, start->func + 4);
+    machine->WriteRegister(RET_ADDR_REG, start->exitPC);
+    machine->WriteRegister(STACK_REG,
+                           space->StackTop(currentThread->stackSlot) - 16);
+    delete start;
+
+    space->RestoreState();
+    DEBUG('e', "Running forked thread %s.\n", currentThread->GetName());
+    machine->Run();
+}
+
 
 /// Handle a system call exception.
 ///
@@ -407,6 +439,100 @@ SyscallHandler(ExceptionType _et)
             break;
         }
 
+        case SC_FORK: {
+            int func = machine->ReadRegister(4);
+            int exitPC = machine->ReadRegister(5);
+            DEBUG('e', "`Fork` requested for function 0x%X.\n", func);
+
+            if (func == 0 || exitPC == 0) {
+                DEBUG('e', "Error: null function or return address.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            AddressSpace *space = currentThread->space;
+            int slot = space->AllocateStack();
+            if (slot == -1) {
+                DEBUG('e', "Error: no stack left for a new thread.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+
+            Thread *newThread = new Thread(currentThread->GetName(), 1);
+            if (newThread->pid < 0) {
+                DEBUG('e', "Error: too many threads.\n");
+                delete newThread;
+                space->FreeStack(slot);
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            space->AddReference();
+            newThread->LoadAddressSpace(space);
+            newThread->stackSlot = slot;
+
+            UserThreadStart *start = new UserThreadStart;
+            start->func   = func;
+            start->exitPC = exitPC;
+            newThread->Fork(runUserThread, start);
+
+            machine->WriteRegister(2, newThread->pid);
+            break;
+        }
+
+        case SC_YIELD: {
+            DEBUG('e', "`Yield` requested.\n");
+            currentThread->Yield();
+            break;
+        }
+
+        case SC_SLEEP: {
+            unsigned ticks = machine->ReadRegister(4);
+            DEBUG('e', "`Sleep` requested for %u ticks.\n", ticks);
+            currentThread->SleepFor(ticks);
+            break;
+        }
+
+        case SC_FUTEX_WAIT: {
+            int addr = machine->ReadRegister(4);
+            int expected = machine->ReadRegister(5);
+            DEBUG('e', "`FutexWait` requested on 0x%X.\n", addr);
+
+            if (addr == 0 || addr % sizeof (int) != 0) {
+                DEBUG('e', "Error: bad futex address.\n");
+                machine->WriteRegister(2, -1);
+                break;
+            }
+            bool slept = futexTable->Wait(currentThread->space, addr,
+                                          expected);
+            machine->WriteRegister(2, slept ? 0 : -1);
+            break;
+        }
+
+        case SC_FUTEX_WAKE: {
+            int addr = machine->ReadRegister(4);
+            int count = machine->ReadRegister(5);
+            DEBUG('e', "`FutexWake` requested on 0x%X.\n", addr);
+
+            if (count <= 0) {
+                machine->WriteRegister(2, 0);
+                break;
+            }
+            unsigned woken = futexTable->Wake(currentThread->space, addr,
+                                              count);
+            machine->WriteRegister(2, woken);
+            break;
+        }
+
+        case SC_ATOMIC_SEQUENCE: {
+            unsigned begin = machine->ReadRegister(4);
+            unsigned end = machine->ReadRegister(5);
+            DEBUG('e', "Atomic sequence at 0x%X-0x%X.\n", begin, end);
+
+            bool ok = currentThread->space->SetAtomicSequence(begin, end);
+            machine->WriteRegister(2, ok ? 0 : -1);
+            break;
+        }
+
         case SC_JOIN: {
             SpaceId id = machine->ReadRegister(4);
             DEBUG('e', "`Join` requested for id %d.\n", id);
@@ -449,10 +575,14 @@ PageFaultHandler(ExceptionType _et){
     #endif
 
     // Guardar bit de referencia y de modificacion en la pagina de tablas correspondiente
-    unsigned oldVpn = machine->GetMMU()->tlb[i].virtualPage;
-    TranslationEntry *oldEntry = currentThread->space->GetEntry(oldVpn);
-    oldEntry->use = machine->GetMMU()->tlb[i].use;
-    oldEntry->dirty = machine->GetMMU()->tlb[i].dirty;
+    // Entries dropped on a context switch or a page out are no longer
+    // valid, and their bits were saved already or belong to another page.
+    if (machine->GetMMU()->tlb[i].valid) {
+        unsigned oldVpn = machine->GetMMU()->tlb[i].virtualPage;
+        TranslationEntry *oldEntry = currentThread->space->GetEntry(oldVpn);
+        oldEntry->use = machine->GetMMU()->tlb[i].use;
+        oldEntry->dirty = machine->GetMMU()->tlb[i].dirty;
+    }
 
     machine->GetMMU()->tlb[i].virtualPage  = entry->virtualPage;
     machine->GetMMU()->tlb[i].physicalPage = entry->physicalPage;
@@ -0,0 +1,114 @@
+/// Routines to block and wake threads on user-level futexes.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "futex.hh"
+#include "threads/system.hh"
+
+
+FutexTable::FutexTable()
+{
+    futexes = new List<Futex *>;
+}
+
+/// Assume nobody is blocked on a futex.
+FutexTable::~FutexTable()
+{
+    ASSERT(futexes->IsEmpty());
+    delete futexes;
+}
+
+FutexTable::Futex *
+FutexTable::Find(AddressSpace *space, unsigned vaddr) const
+{
+    struct Search {
+        AddressSpace *space;
+        unsigned vaddr;
+        Futex *result;
+
+        static void
+        Match(Futex *futex, void *search_)
+        {
+            Search *search = (Search *) search_;
+            if (futex->space == search->space
+                  && futex->vaddr == search->vaddr) {
+                search->result = futex;
+            }
+        }
+    };
+
+    Search search = { space, vaddr, nullptr };
+    futexes->Apply(Search::Match, &search);
+    return search.result;
+}
+
+bool
+FutexTable::Wait(AddressSpace *space, unsigned vaddr, int expected)
+{
+    ASSERT(space != nullptr);
+    ASSERT(vaddr % sizeof (int) == 0);
+
+    for (;;) {
+        IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+        // A failed read raised a page fault that brought the page in, but
+        // the fault may have let other threads run, so read again.  A read
+        // that succeeds did not block, and interrupts are still off, so
+        // nobody can change the word or call `Wake` until we are queued.
+        int value;
+        if (machine->ReadMem(vaddr, sizeof value, &value)) {
+            if (value != expected) {
+                interrupt->SetLevel(oldLevel);
+                return false;
+            }
+
+            Futex *futex = Find(space, vaddr);
+            if (futex == nullptr) {
+                futex = new Futex;
+                futex->space   = space;
+                futex->vaddr   = vaddr;
+                futex->waiters = new WaitQueue;
+                futexes->Append(futex);
+            }
+            DEBUG('e', "Thread \"%s\" waiting on futex 0x%X\n",
+                  currentThread->GetName(), vaddr);
+            futex->waiters->Append(currentThread);
+            currentThread->Sleep();
+
+            interrupt->SetLevel(oldLevel);
+            return true;
+        }
+
+        interrupt->SetLevel(oldLevel);
+    }
+}
+
+unsigned
+FutexTable::Wake(AddressSpace *space, unsigned vaddr, unsigned count)
+{
+    ASSERT(space != nullptr);
+
+    IntStatus oldLevel = interrupt->SetLevel(INT_OFF);
+
+    unsigned woken = 0;
+    Futex *futex = Find(space, vaddr);
+    if (futex != nullptr) {
+        Thread *thread;
+        while (woken < count && (thread = futex->waiters->Pop()) != nullptr) {
+            scheduler->ReadyToRun(thread);
+            woken++;
+        }
+        if (futex->waiters->IsEmpty()) {
+            futexes->Remove(futex);
+            delete futex->waiters;
+            delete futex;
+        }
+    }
+    DEBUG('e', "Woke %u threads on futex 0x%X\n", woken, vaddr);
+
+    interrupt->SetLevel(oldLevel);
+    return woken;
+}
@@ -0,0 +1,63 @@
+/// Kernel wait queues for user-level synchronization.
+///
+/// A futex ("fast user-space mutex") is just a word in user memory.  User
+/// programs build locks and condition variables on top of such words with
+/// atomic operations, and only call into the kernel when they have to
+/// block or to wake somebody up:
+///
+/// * `FutexWait(addr, expected)` blocks the caller, but only if the word at
+///   `addr` still holds `expected`; the check and the blocking are atomic,
+///   so a wake up between the user's own check and the call is not lost.
+/// * `FutexWake(addr, n)` wakes up to `n` threads blocked on `addr`.
+///
+/// Futexes are keyed by address space and virtual address, so threads of
+/// different programs never share one.  The kernel keeps state only for
+/// futexes somebody is blocked on.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_USERPROG_FUTEX__HH
+#define NACHOS_USERPROG_FUTEX__HH
+
+
+#include "threads/wait_queue.hh"
+
+
+class AddressSpace;
+
+class FutexTable {
+public:
+
+    FutexTable();
+
+    ~FutexTable();
+
+    /// Block the current thread on the futex at `vaddr` of `space`, if the
+    /// word there equals `expected`.
+    ///
+    /// Return false without blocking if it does not.
+    bool Wait(AddressSpace *space, unsigned vaddr, int expected);
+
+    /// Wake up to `count` threads blocked on the futex at `vaddr` of
+    /// `space`, highest priority first.  Return how many were woken.
+    unsigned Wake(AddressSpace *space, unsigned vaddr, unsigned count);
+
+private:
+
+    struct Futex {
+        AddressSpace *space;
+        unsigned vaddr;
+        WaitQueue *waiters;
+    };
+
+    /// Futexes with at least one waiter.
+    List<Futex *> *futexes;
+
+    /// Find the futex for `space` and `vaddr`, null if nobody waits on it.
+    Futex *Find(AddressSpace *space, unsigned vaddr) const;
+};
+
+
+#endif
@@ -25,6 +25,10 @@
 #define SC_JOIN     3
 #define SC_FORK     4
 #define SC_YIELD    5
+#define SC_SLEEP    6
+#define SC_FUTEX_WAIT  7
+#define SC_FUTEX_WAKE  8
+#define SC_ATOMIC_SEQUENCE  9
 #define SC_CREATE  10
 #define SC_REMOVE  11
 #define SC_OPEN    12
@@ -71,13 +75,47 @@ int Join(SpaceId id);
 /// threads to run within a user program.
 
 /// Fork a thread to run a procedure (`func`) in the *same* address space as
-/// the current thread.
+/// the current thread.  The new thread gets a stack of its own, and calls
+/// `Exit` when `func` returns.  At most `MAX_USER_THREADS` forked threads
+/// can be alive at once.
+///
+/// Return an identifier that can be passed to `Join`, or -1 on error.
 int Fork(void (*func)(void));
 
 /// Yield the CPU to another runnable thread, whether in this address space
 /// or not.
 void Yield();
 
+/// Block the calling thread for `ticks` ticks of simulated time, letting
+/// other threads run meanwhile.  Use this instead of busy waiting.
+void Sleep(unsigned ticks);
+
+
+/// User-level synchronization support: futexes and atomic operations.
+///
+/// A futex is a word in user memory.  Locks and condition variables
+/// manipulate it with `AtomicCompareAndSwap`, and only make a system call
+/// when they have to block or wake somebody up (see `lib.c`).
+
+/// Block until woken up by `FutexWake`, but only if `*addr == expected`.
+///
+/// Return 0 after being woken up, -1 at once if `*addr != expected`.
+int FutexWait(int *addr, int expected);
+
+/// Wake up to `count` threads blocked in `FutexWait` on `addr`.
+///
+/// Return the number of threads woken up.
+int FutexWake(int *addr, int count);
+
+/// If `*addr == expected`, set it to `desired`.  Return the old value of
+/// `*addr` in any case.  This is not a system call: it runs in user mode
+/// as a restartable sequence (see `start.s`).
+int AtomicCompareAndSwap(int *addr, int expected, int desired);
+
+/// Tell the kernel where the program's restartable atomic sequence lies.
+/// Called by the startup code; programs need not call it.
+int RegisterAtomicSequence(void *begin, void *end);
+
 
 /// File system operations: `Create`, `Open`, `Read`, `Write`, `Close`.
 ///
@@ -0,0 +1,36 @@
+#! /bin/bash
+
+# Compare page replacement policies on `matmult` and `sort`.
+#
+# Runs every program with every policy and every memory size, and prints
+# the page faults and the pages written to swap by each run.  Run from the
+# `code` directory, for instance:
+#
+#     vmem/bench_replacement.sh 16 24 32
+#
+# Memory sizes (in pages, as for `-m`) default to 8 16 32 64.  Set POLICIES
+# to compare others, for instance `POLICIES="clock wsclock,500"`.
+
+sizes=${*:-8 16 32 64}
+policies=${POLICIES:-fifo random clock wsclock aging}
+programs="matmult sort"
+
+make >/dev/null
+
+(cd ./userland; make >/dev/null)
+
+printf "%-8s %5s %-14s %10s %10s %12s\n" \
+       program pages policy faults written ticks
+for program in $programs; do
+    for m in $sizes; do
+        for policy in $policies; do
+            output=$(cd ./vmem; ./nachos -m "$m" -rp "$policy" \
+                                         -x "../userland/$program")
+            faults=$(echo "$output" | sed -n 's/^Paging: faults \([0-9]*\).*/\1/p')
+            written=$(echo "$output" | sed -n 's/^Swap: pages written \([0-9]*\),.*/\1/p')
+            ticks=$(echo "$output" | sed -n 's/^Ticks: total \([0-9]*\).*/\1/p')
+            printf "%-8s %5s %-14s %10s %10s %12s\n" \
+                   "$program" "$m" "$policy" "$faults" "$written" "$ticks"
+        done
+    done
+done
@@ -0,0 +1,439 @@
+/// Routines to keep track of physical memory frames, and to choose which
+/// to take a page out of.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "core_map.hh"
+#include "machine/translation_entry.hh"
+#include "threads/system.hh"
+#include "userprog/address_space.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+static const char *POLICY_NAMES[] = {
+    "fifo", "random", "clock", "wsclock", "aging"
+};
+
+CoreMap::CoreMap(unsigned numFrames_, ReplacementPolicy policy_,
+                 unsigned param_)
+{
+    ASSERT(numFrames_ > 0);
+
+    numFrames  = numFrames_;
+    frames     = new Frame [numFrames];
+    freeFrames = new Bitmap(numFrames);
+    for (unsigned i = 0; i < numFrames; i++) {
+        frames[i].space   = nullptr;
+        frames[i].vpn     = 0;
+        frames[i].age     = 0;
+        frames[i].lastUse = 0;
+        frames[i].idle    = false;
+    }
+
+    policy = policy_;
+    param  = param_;
+    if (param == 0) {
+        param = policy == REPLACE_WSCLOCK ? DEFAULT_TAU : DEFAULT_PERIOD;
+    }
+    hand         = 0;
+    cleanHand    = 0;
+    lastAging    = 0;
+    victims      = 0;
+    dirtyVictims = 0;
+}
+
+CoreMap::~CoreMap()
+{
+    delete [] frames;
+    delete freeFrames;
+}
+
+bool
+CoreMap::ParsePolicy(const char *s, ReplacementPolicy *policyPtr,
+                     unsigned *paramPtr)
+{
+    ASSERT(s != nullptr);
+    ASSERT(policyPtr != nullptr);
+    ASSERT(paramPtr != nullptr);
+
+    const char *comma = strchr(s, ',');
+    size_t nameLength = comma != nullptr ? (size_t) (comma - s) : strlen(s);
+
+    unsigned n = sizeof POLICY_NAMES / sizeof *POLICY_NAMES;
+    unsigned i = 0;
+    while (i < n && (strlen(POLICY_NAMES[i]) != nameLength
+                     || strncmp(POLICY_NAMES[i], s, nameLength) != 0)) {
+        i++;
+    }
+    if (i == n) {
+        return false;
+    }
+
+    unsigned param = 0;
+    if (comma != nullptr) {
+        char *end;
+        long value = strtol(comma + 1, &end, 10);
+        if (*end != '\0' || value <= 0) {
+            return false;
+        }
+        param = value;
+    }
+
+    *policyPtr = (ReplacementPolicy) i;
+    *paramPtr  = param;
+    return true;
+}
+
+int
+CoreMap::Allocate(AddressSpace *space, unsigned vpn)
+{
+    ASSERT(space != nullptr);
+
+    if (policy == REPLACE_AGING) {
+        Age();
+    }
+
+    int frame = freeFrames->Find();
+    if (frame == -1) {
+        return -1;
+    }
+    frames[frame].space   = space;
+    frames[frame].vpn     = vpn;
+    frames[frame].age     = 0x80;  // Just used.
+    frames[frame].lastUse = stats->totalTicks;
+    frames[frame].idle    = false;
+    return frame;
+}
+
+void
+CoreMap::Free(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+    ASSERT(frames[frame].space != nullptr);
+
+    Unmap(frame);
+    frames[frame].space = nullptr;
+    freeFrames->Clear(frame);
+}
+
+unsigned
+CoreMap::CountFree() const
+{
+    return freeFrames->CountClear();
+}
+
+AddressSpace *
+CoreMap::GetSpace(unsigned frame) const
+{
+    ASSERT(frame < numFrames);
+    return frames[frame].space;
+}
+
+unsigned
+CoreMap::GetVpn(unsigned frame) const
+{
+    ASSERT(frame < numFrames);
+    ASSERT(frames[frame].space != nullptr);
+    return frames[frame].vpn;
+}
+
+TranslationEntry *
+CoreMap::EntryOf(unsigned frame) const
+{
+    return frames[frame].space->GetEntry(frames[frame].vpn);
+}
+
+/// TLB entries are matched by frame rather than by virtual page, so that
+/// nothing is assumed about which address space they belong to.
+void
+CoreMap::SyncTlb()
+{
+#ifdef USE_TLB
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    for (unsigned i = 0; i < TLB_SIZE; i++) {
+        unsigned frame = tlb[i].physicalPage;
+        if (!tlb[i].valid || frame >= numFrames
+              || frames[frame].space == nullptr) {
+            continue;
+        }
+        TranslationEntry *entry = EntryOf(frame);
+        entry->use   = entry->use   || tlb[i].use;
+        entry->dirty = entry->dirty || tlb[i].dirty;
+    }
+#endif
+}
+
+void
+CoreMap::ClearDirty(unsigned frame)
+{
+    ASSERT(frame < numFrames);
+    ASSERT(frames[frame].space != nullptr);
+
+    EntryOf(frame)->dirty = false;
+#ifdef USE_TLB
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    for (unsigned i = 0; i < TLB_SIZE; i++) {
+        if (tlb[i].valid && tlb[i].physicalPage == frame) {
+            tlb[i].dirty = false;
+        }
+    }
+#endif
+}
+
+void
+CoreMap::ClearUse(unsigned frame)
+{
+    EntryOf(frame)->use = false;
+#ifdef USE_TLB
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    for (unsigned i = 0; i < TLB_SIZE; i++) {
+        if (tlb[i].valid && tlb[i].physicalPage == frame) {
+            tlb[i].use = false;
+        }
+    }
+#endif
+}
+
+void
+CoreMap::Unmap(unsigned frame)
+{
+#ifdef USE_TLB
+    TranslationEntry *tlb = machine->GetMMU()->tlb;
+    TranslationEntry *entry = EntryOf(frame);
+    for (unsigned i = 0; i < TLB_SIZE; i++) {
+        if (tlb[i].valid && tlb[i].physicalPage == frame) {
+            entry->use   = entry->use   || tlb[i].use;
+            entry->dirty = entry->dirty || tlb[i].dirty;
+            tlb[i].valid = false;
+        }
+    }
+#endif
+}
+
+/// Use bits gathered over several periods count for the first one only;
+/// ages are approximate anyway.
+void
+CoreMap::Age()
+{
+    unsigned long periods = (stats->totalTicks - lastAging) / param;
+    if (periods == 0) {
+        return;
+    }
+    lastAging += periods * param;
+
+    SyncTlb();
+    for (unsigned i = 0; i < numFrames; i++) {
+        if (frames[i].space == nullptr) {
+            continue;
+        }
+        bool used = EntryOf(i)->use;
+        uint8_t age = frames[i].age >> 1 | (used ? 0x80 : 0);
+        frames[i].age = periods - 1 >= 8 ? 0 : age >> (periods - 1);
+        if (used) {
+            ClearUse(i);
+        }
+    }
+}
+
+unsigned
+CoreMap::PickVictim()
+{
+    ASSERT(CountFree() < numFrames);
+
+    unsigned victim;
+    switch (policy) {
+        case REPLACE_FIFO:
+            do {
+                victim = hand;
+                hand = (hand + 1) % numFrames;
+            } while (frames[victim].space == nullptr);
+            break;
+        case REPLACE_RANDOM:
+            do {
+                victim = SystemDep::Random() % numFrames;
+            } while (frames[victim].space == nullptr);
+            break;
+        case REPLACE_CLOCK:
+            victim = PickClock();
+            break;
+        case REPLACE_WSCLOCK:
+            victim = PickWsClock();
+            break;
+        case REPLACE_AGING:
+            victim = PickAging();
+            break;
+        default:
+            ASSERT(false);
+            victim = 0;
+    }
+
+    Unmap(victim);
+    victims++;
+    if (EntryOf(victim)->dirty) {
+        dirtyVictims++;
+    }
+    DEBUG('a', "Replacing page %u in frame %u (%s)\n",
+          frames[victim].vpn, victim, POLICY_NAMES[policy]);
+    return victim;
+}
+
+/// A page is old enough if the policy would take it over a page just used:
+/// out of the working set for `REPLACE_WSCLOCK`, not used in the last four
+/// periods for `REPLACE_AGING`, and found not used by two looks in a row
+/// otherwise.  Writing back pages that are still being written to would
+/// only add writes.
+int
+CoreMap::PickDirty()
+{
+    if (policy == REPLACE_AGING) {
+        Age();
+    }
+    SyncTlb();
+    unsigned long now = stats->totalTicks;
+    for (unsigned n = 0; n < numFrames; n++) {
+        unsigned frame = cleanHand;
+        cleanHand = (cleanHand + 1) % numFrames;
+
+        if (frames[frame].space == nullptr) {
+            continue;
+        }
+        TranslationEntry *entry = EntryOf(frame);
+        bool seenIdle = frames[frame].idle;
+        frames[frame].idle = !entry->use;
+        if (!entry->dirty || entry->use) {
+            continue;
+        }
+        bool old;
+        if (policy == REPLACE_WSCLOCK) {
+            old = now - frames[frame].lastUse > param;
+        } else if (policy == REPLACE_AGING) {
+            old = frames[frame].age < 0x10;
+        } else {
+            old = seenIdle;
+        }
+        if (old) {
+            return frame;
+        }
+    }
+    return -1;
+}
+
+/// Up to four sweeps: the first looks for a frame neither used nor dirty;
+/// the second for one dirty but not used, clearing use bits, so that the
+/// third or fourth are bound to find one.
+unsigned
+CoreMap::PickClock()
+{
+    SyncTlb();
+    for (unsigned sweep = 0; sweep < 4; sweep++) {
+        bool wantDirty = sweep % 2 == 1;
+        for (unsigned n = 0; n < numFrames; n++) {
+            unsigned frame = hand;
+            hand = (hand + 1) % numFrames;
+
+            if (frames[frame].space == nullptr) {
+                continue;
+            }
+            TranslationEntry *entry = EntryOf(frame);
+            if (!entry->use && entry->dirty == wantDirty) {
+                return frame;
+            }
+            if (wantDirty) {
+                ClearUse(frame);
+            }
+        }
+    }
+    ASSERT(false);
+    return hand;
+}
+
+/// Dirty pages out of the working set would be scheduled to be written
+/// and skipped; since writes are done on the spot, the first of them is
+/// taken if a whole sweep finds no clean page out of the working set.
+unsigned
+CoreMap::PickWsClock()
+{
+    SyncTlb();
+    unsigned long now = stats->totalTicks;
+    int oldDirty = -1, clean = -1, any = -1;
+    for (unsigned n = 0; n < numFrames; n++) {
+        unsigned frame = hand;
+        hand = (hand + 1) % numFrames;
+
+        if (frames[frame].space == nullptr) {
+            continue;
+        }
+        if (any == -1) {
+            any = frame;
+        }
+        TranslationEntry *entry = EntryOf(frame);
+        if (entry->use) {
+            ClearUse(frame);
+            frames[frame].lastUse = now;
+            continue;
+        }
+        if (now - frames[frame].lastUse > param) {
+            if (!entry->dirty) {
+                return frame;
+            }
+            if (oldDirty == -1) {
+                oldDirty = frame;
+            }
+        } else if (!entry->dirty && clean == -1) {
+            clean = frame;
+        }
+    }
+
+    if (oldDirty != -1) {
+        return oldDirty;
+    }
+    if (clean != -1) {
+        return clean;
+    }
+    return any;  // Every page is in the working set and dirty.
+}
+
+/// Among frames of equal age, clean ones go first, and then those found
+/// first from the hand.
+unsigned
+CoreMap::PickAging()
+{
+    Age();
+    SyncTlb();
+
+    unsigned best = hand;
+    unsigned bestRank = ~0u;
+    for (unsigned n = 0; n < numFrames; n++) {
+        unsigned frame = (hand + n) % numFrames;
+        if (frames[frame].space == nullptr) {
+            continue;
+        }
+        TranslationEntry *entry = EntryOf(frame);
+        unsigned rank = (unsigned) frames[frame].age << 2
+                        | (entry->use ? 2 : 0) | (entry->dirty ? 1 : 0);
+        if (rank < bestRank) {
+            best = frame;
+            bestRank = rank;
+        }
+    }
+    hand = (best + 1) % numFrames;
+    return best;
+}
+
+void
+CoreMap::Print() const
+{
+    printf("Page replacement: policy %s", POLICY_NAMES[policy]);
+    if (policy == REPLACE_WSCLOCK) {
+        printf(", tau %u", param);
+    } else if (policy == REPLACE_AGING) {
+        printf(", period %u", param);
+    }
+    printf(", %lu victims, %lu dirty\n", victims, dirtyVictims);
+}
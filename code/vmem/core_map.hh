@@ -0,0 +1,162 @@
+/// Data structures to keep track of physical memory frames.
+///
+/// With virtual memory, a frame may hold a page of any address space.  The
+/// core map records, for every frame, which page it holds, so that the
+/// page can be written out and unmapped when the frame is needed for
+/// another one.  Which frame to take is decided by a replacement policy:
+///
+/// * `REPLACE_FIFO`: frames in turn, regardless of their use.
+/// * `REPLACE_RANDOM`: any frame.
+/// * `REPLACE_CLOCK`: enhanced second chance.  Frames are ranked by their
+///   use and dirty bits: first one neither used nor dirty, then one dirty
+///   but not used (clearing use bits on the way), and so on.
+/// * `REPLACE_WSCLOCK`: the working set clock.  A frame not used in the
+///   last `tau` ticks is out of the working set, and taken if clean; a
+///   dirty one is taken only if no clean one is found in a whole sweep.
+/// * `REPLACE_AGING`: an approximation of least recently used.  Every
+///   `period` ticks, each frame's age counter is shifted right, with its
+///   use bit coming in on the left, and the use bit is cleared.  The frame
+///   with the lowest counter is taken.
+///
+/// Use and dirty bits are set by the MMU in the TLB; they are copied back
+/// into the page tables before the policy looks at them, and a use bit is
+/// cleared both in the page table and in the TLB.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_COREMAP__HH
+#define NACHOS_VMEM_COREMAP__HH
+
+
+#include "lib/bitmap.hh"
+
+#include <stdint.h>
+
+
+class AddressSpace;
+class TranslationEntry;
+
+enum ReplacementPolicy {
+    REPLACE_FIFO,
+    REPLACE_RANDOM,
+    REPLACE_CLOCK,
+    REPLACE_WSCLOCK,
+    REPLACE_AGING
+};
+
+class CoreMap {
+public:
+
+    /// Ticks a page stays in the working set, for `REPLACE_WSCLOCK`.
+    static const unsigned DEFAULT_TAU = 2000;
+
+    /// Ticks between age shifts, for `REPLACE_AGING`.
+    static const unsigned DEFAULT_PERIOD = 500;
+
+    /// Initialize a core map of `numFrames` free frames, to be replaced
+    /// according to `policy`.
+    ///
+    /// `param` is the `tau` of `REPLACE_WSCLOCK` or the `period` of
+    /// `REPLACE_AGING`; zero means the default.  Other policies ignore it.
+    CoreMap(unsigned numFrames, ReplacementPolicy policy, unsigned param = 0);
+
+    ~CoreMap();
+
+    /// Parse a policy given as `<name>[,<param>]`, for instance `aging,200`.
+    /// Names are `fifo`, `random`, `clock`, `wsclock` and `aging`.
+    ///
+    /// Return false if the string is not valid.
+    static bool ParsePolicy(const char *s, ReplacementPolicy *policy,
+                            unsigned *param);
+
+    /// Take a free frame for page `vpn` of `space`.
+    ///
+    /// Return the frame, or -1 if every frame is in use.
+    int Allocate(AddressSpace *space, unsigned vpn);
+
+    /// Give back `frame`, which must be in use.  Any TLB entry for it is
+    /// dropped, after its use and dirty bits are saved in the page table.
+    void Free(unsigned frame);
+
+    /// Number of free frames.
+    unsigned CountFree() const;
+
+    /// Owner of `frame`, null if it is free.
+    AddressSpace *GetSpace(unsigned frame) const;
+
+    /// Virtual page held by `frame`, which must be in use.
+    unsigned GetVpn(unsigned frame) const;
+
+    /// Choose a frame to take a page out of.  Free frames are not
+    /// considered, and at least one frame must be in use.
+    ///
+    /// The page table entry of the page it holds is brought up to date,
+    /// and the page is unmapped from the TLB.
+    unsigned PickVictim();
+
+    /// Choose a frame holding a dirty page that has not been used lately,
+    /// to write it back before it is picked as a victim.  Return -1 if
+    /// there is none.
+    int PickDirty();
+
+    /// Clear the dirty bit of the page held by `frame`, once it has been
+    /// written back.
+    void ClearDirty(unsigned frame);
+
+    /// Copy the use and dirty bits in the TLB to the page tables.
+    void SyncTlb();
+
+    /// Print the policy and replacement counters.
+    void Print() const;
+
+private:
+
+    struct Frame {
+        AddressSpace *space;  ///< Owner, null if the frame is free.
+        unsigned vpn;
+        uint8_t age;          ///< Age counter, for `REPLACE_AGING`.
+        unsigned long lastUse;  ///< Tick of the last use seen, for
+                                ///< `REPLACE_WSCLOCK`.
+        bool idle;            ///< Found not used by the last look of
+                              ///< `PickDirty`.
+    };
+
+    Frame *frames;
+    unsigned numFrames;
+    Bitmap *freeFrames;
+
+    ReplacementPolicy policy;
+    unsigned param;
+
+    /// Next frame to look at, for the policies that sweep.
+    unsigned hand;
+
+    /// Next frame to look at for dirty pages; see `PickDirty`.
+    unsigned cleanHand;
+
+    /// Last tick up to which age counters were shifted.
+    unsigned long lastAging;
+
+    /// Counters.
+    unsigned long victims, dirtyVictims;
+
+    TranslationEntry *EntryOf(unsigned frame) const;
+
+    /// Clear the use bit of the page held by `frame`.
+    void ClearUse(unsigned frame);
+
+    /// Drop the TLB entries that map `frame`.
+    void Unmap(unsigned frame);
+
+    /// Shift the age counters for the periods elapsed since the last time.
+    void Age();
+
+    unsigned PickClock();
+    unsigned PickWsClock();
+    unsigned PickAging();
+};
+
+
+#endif
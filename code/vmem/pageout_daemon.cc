@@ -0,0 +1,134 @@
+/// Routines for the pageout daemon.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#ifdef SWAP
+
+#include "pageout_daemon.hh"
+#include "threads/semaphore.hh"
+#include "threads/system.hh"
+#include "userprog/address_space.hh"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+PageoutDaemon::PageoutDaemon(unsigned lowWater_, unsigned highWater_)
+{
+    ASSERT(lowWater_ <= highWater_);
+    ASSERT(highWater_ < machine->GetNumPhysicalPages());
+
+    lowWater  = lowWater_;
+    highWater = highWater_;
+    wakeup    = new Semaphore("pageout daemon", 0);
+    awake     = false;
+    rounds    = 0;
+    reclaimed = 0;
+    cleaned   = 0;
+
+    Thread *t = new Thread("pageout daemon", 0, MAX_PRIORITY);
+    t->Fork(Run, this);
+}
+
+PageoutDaemon::~PageoutDaemon()
+{
+    delete wakeup;
+}
+
+bool
+PageoutDaemon::ParseWatermarks(const char *s, unsigned *lowWater,
+                               unsigned *highWater)
+{
+    ASSERT(s != nullptr);
+    ASSERT(lowWater != nullptr);
+    ASSERT(highWater != nullptr);
+
+    char *end;
+    long low = strtol(s, &end, 10);
+    if (*end != ',' || low < 0) {
+        return false;
+    }
+    long high = strtol(end + 1, &end, 10);
+    if (*end != '\0' || high < low) {
+        return false;
+    }
+
+    *lowWater  = low;
+    *highWater = high;
+    return true;
+}
+
+void
+PageoutDaemon::Check()
+{
+    if (awake || coreMap->CountFree() >= lowWater) {
+        return;
+    }
+    DEBUG('a', "%u frames free, waking the pageout daemon\n",
+          coreMap->CountFree());
+    awake = true;
+    wakeup->V();
+    currentThread->Yield();
+}
+
+unsigned
+PageoutDaemon::GetLowWater() const
+{
+    return lowWater;
+}
+
+void
+PageoutDaemon::Run(void *daemon_)
+{
+    PageoutDaemon *daemon = (PageoutDaemon *) daemon_;
+    for (;;) {
+        daemon->wakeup->P();
+        daemon->rounds++;
+        daemon->Reclaim();
+        daemon->Clean();
+        daemon->awake = false;
+    }
+}
+
+/// Victims are chosen one by one, as eviction from a fault would, but all
+/// in the same round.
+void
+PageoutDaemon::Reclaim()
+{
+    while (coreMap->CountFree() < highWater) {
+        unsigned frame = coreMap->PickVictim();
+        coreMap->GetSpace(frame)->SwapPage(coreMap->GetVpn(frame));
+        coreMap->Free(frame);
+        reclaimed++;
+    }
+    DEBUG('a', "Pageout daemon: %u frames free\n", coreMap->CountFree());
+}
+
+/// About as many pages as a round frees are cleaned, so that the next
+/// round is likely to find its victims clean.
+void
+PageoutDaemon::Clean()
+{
+    for (unsigned n = 0; n < highWater - lowWater; n++) {
+        int frame = coreMap->PickDirty();
+        if (frame == -1) {
+            break;
+        }
+        coreMap->GetSpace(frame)->CleanPage(coreMap->GetVpn(frame));
+        cleaned++;
+    }
+}
+
+void
+PageoutDaemon::Print() const
+{
+    printf("Pageout daemon: watermarks %u/%u, %lu rounds, %lu frames "
+           "reclaimed, %lu pages cleaned\n",
+           lowWater, highWater, rounds, reclaimed, cleaned);
+}
+
+#endif
@@ -0,0 +1,83 @@
+/// A kernel thread that keeps a reserve of free frames.
+///
+/// Without it, a page fault that finds every frame in use has to pick a
+/// victim and, if the victim is dirty, write it to swap before the faulting
+/// page can be loaded.  The pageout daemon does that work ahead of time.
+/// It sleeps until the number of free frames falls below a low watermark;
+/// then it frees frames, choosing the victims with the replacement policy,
+/// until there are as many free as a high watermark.  Before going back to
+/// sleep, it writes back dirty pages that have not been used lately,
+/// without taking them out of memory, so that the victims of later rounds
+/// are likely to be clean and dropped without a write.
+///
+/// The daemon runs at the highest priority, and a faulting thread that
+/// wakes it gives up the processor, so the reserve is refilled before the
+/// fault takes a frame.  A fault still evicts a page itself if it finds no
+/// free frame.
+///
+/// A round runs without switching threads, since swap I/O does not block
+/// with the stub file system; a page cannot change hands while the daemon
+/// is writing it.
+///
+/// Only built with *SWAP*, which the daemon needs to write pages out.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_PAGEOUTDAEMON__HH
+#define NACHOS_VMEM_PAGEOUTDAEMON__HH
+
+
+class Semaphore;
+
+class PageoutDaemon {
+public:
+
+    /// Start the daemon, to keep between `lowWater` and `highWater` frames
+    /// free.  `highWater` must be less than the number of frames.
+    PageoutDaemon(unsigned lowWater, unsigned highWater);
+
+    /// The thread is not stopped; only meant for when Nachos halts.
+    ~PageoutDaemon();
+
+    /// Parse watermarks given as `<low>,<high>`, for instance `4,8`.
+    ///
+    /// Return false if the string is not valid.
+    static bool ParseWatermarks(const char *s, unsigned *lowWater,
+                                unsigned *highWater);
+
+    /// Wake the daemon, and let it run, if fewer than `lowWater` frames
+    /// are free.  To be called before taking a frame.
+    void Check();
+
+    /// Frames below which the daemon is woken.
+    unsigned GetLowWater() const;
+
+    /// Print the watermarks and counters.
+    void Print() const;
+
+private:
+
+    unsigned lowWater, highWater;
+
+    /// The daemon sleeps on it.
+    Semaphore *wakeup;
+
+    /// Whether the daemon has been woken and has not finished its round.
+    bool awake;
+
+    /// Counters.
+    unsigned long rounds, reclaimed, cleaned;
+
+    static void Run(void *daemon);
+
+    /// Free frames until `highWater` are free.
+    void Reclaim();
+
+    /// Write back dirty pages not used lately.
+    void Clean();
+};
+
+
+#endif
@@ -0,0 +1,75 @@
+/// Routines to manage the swap area.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+
+#include "swap_area.hh"
+#include "machine/mmu.hh"
+#include "threads/system.hh"
+
+
+SwapArea::SwapArea(const char *fileName_, unsigned numSlots_)
+{
+    ASSERT(fileName_ != nullptr);
+    ASSERT(numSlots_ > 0);
+
+    fileName = fileName_;
+    numSlots = numSlots_;
+    slots    = new Bitmap(numSlots);
+
+    DEBUG('a', "Creating swap file %s, %u pages\n", fileName, numSlots);
+    ASSERT(fileSystem->Create(fileName, numSlots * PAGE_SIZE));
+    file = fileSystem->Open(fileName);
+    ASSERT(file != nullptr);
+}
+
+SwapArea::~SwapArea()
+{
+    delete file;
+    fileSystem->Remove(fileName);
+    delete slots;
+}
+
+int
+SwapArea::Allocate()
+{
+    return slots->Find();
+}
+
+void
+SwapArea::Free(unsigned slot)
+{
+    ASSERT(slot < numSlots);
+    ASSERT(slots->Test(slot));
+    slots->Clear(slot);
+}
+
+void
+SwapArea::Write(unsigned slot, const char *from)
+{
+    ASSERT(slot < numSlots);
+    ASSERT(from != nullptr);
+
+    int written = file->WriteAt(from, PAGE_SIZE, slot * PAGE_SIZE);
+    ASSERT(written == (int) PAGE_SIZE);
+    stats->numSwappedPages++;
+}
+
+void
+SwapArea::Read(unsigned slot, char *into)
+{
+    ASSERT(slot < numSlots);
+    ASSERT(into != nullptr);
+
+    int read = file->ReadAt(into, PAGE_SIZE, slot * PAGE_SIZE);
+    ASSERT(read == (int) PAGE_SIZE);
+    stats->numSwapReads++;
+}
+
+unsigned
+SwapArea::CountFree() const
+{
+    return slots->CountClear();
+}
@@ -0,0 +1,58 @@
+/// The area of the disk where pages are kept while out of memory.
+///
+/// Every address space keeps its pages in a single swap file, shared by
+/// all of them and created with room for a fixed number of pages, or
+/// slots.  A page gets a slot the first time it is written out, and keeps
+/// it until the address space lets the page go: while the page is not
+/// changed, the copy in the slot stays good, and the page can be dropped
+/// from memory without writing it again.
+///
+/// Copyright (c) 2016-2021 Docentes de la Universidad Nacional de Rosario.
+/// All rights reserved.  See `copyright.h` for copyright notice and
+/// limitation of liability and disclaimer of warranty provisions.
+
+#ifndef NACHOS_VMEM_SWAPAREA__HH
+#define NACHOS_VMEM_SWAPAREA__HH
+
+
+#include "filesys/open_file.hh"
+#include "lib/bitmap.hh"
+
+
+/// Number of slots of the swap area.
+const unsigned DEFAULT_SWAP_SLOTS = 1024;
+
+class SwapArea {
+public:
+
+    /// Create the swap file `fileName`, with room for `numSlots` pages.
+    /// The name is not copied.
+    SwapArea(const char *fileName, unsigned numSlots = DEFAULT_SWAP_SLOTS);
+
+    /// Close the swap file and remove it.
+    ~SwapArea();
+
+    /// Take a free slot.  Return -1 if there is none.
+    int Allocate();
+
+    /// Give back `slot`, which must be in use.
+    void Free(unsigned slot);
+
+    /// Write the page at `from` into `slot`.
+    void Write(unsigned slot, const char *from);
+
+    /// Read the page in `slot` into `into`.
+    void Read(unsigned slot, char *into);
+
+    /// Number of free slots.
+    unsigned CountFree() const;
+
+private:
+    const char *fileName;
+    OpenFile *file;
+    unsigned numSlots;
+    Bitmap *slots;  ///< Slots in use.
+};
+
+
+#endif